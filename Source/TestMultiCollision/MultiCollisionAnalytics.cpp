@@ -0,0 +1,249 @@
+#include "MultiCollisionAnalytics.h"
+#include "MultiCollisionMovementComponent.h"
+#include "Runtime/Core/Public/Misc/FileHelper.h"
+#include "Runtime/Core/Public/Misc/Paths.h"
+#include "Runtime/CoreUObject/Public/UObject/UObjectIterator.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogMultiCollisionAnalytics, Log, All);
+
+static int32 AnalyticsCVar = 0;
+static FAutoConsoleVariableRef CVarAnalytics(
+	TEXT("mc.Analytics"),
+	AnalyticsCVar,
+	TEXT("Collect statistics of additional components of multi-collision characters: sweeps, blocking hits, wins, penetrations and time.\n")
+	TEXT("Use mc.Analytics.DumpCSV and mc.Analytics.Analyze after the playtest.\n")
+	TEXT("0: off, 1: on"),
+	ECVF_Default);
+
+static int32 AnalyticsMinSweepsCVar = 1000;
+static FAutoConsoleVariableRef CVarAnalyticsMinSweeps(
+	TEXT("mc.Analytics.MinSweeps"),
+	AnalyticsMinSweepsCVar,
+	TEXT("Min number of sweeps of the component before analysis flags it."),
+	ECVF_Default);
+
+static FAutoConsoleCommand DumpCSVCommand(
+	TEXT("mc.Analytics.DumpCSV"),
+	TEXT("Write multi-collision components statistics to CSV file in Saved/Profiling. Optional argument is the file name."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		FString Filename;
+		if (FMultiCollisionAnalytics::DumpCSV(Args.Num() > 0 ? Args[0] : FString(), Filename))
+		{
+			UE_LOG(LogMultiCollisionAnalytics, Display, TEXT("Multi-collision analytics written to %s"), *Filename);
+		}
+		else
+		{
+			UE_LOG(LogMultiCollisionAnalytics, Error, TEXT("Can't write multi-collision analytics to %s"), *Filename);
+		}
+	}));
+
+static FAutoConsoleCommand AnalyzeCommand(
+	TEXT("mc.Analytics.Analyze"),
+	TEXT("Log multi-collision components which never block or are always shadowed by a neighbour."),
+	FConsoleCommandDelegate::CreateStatic(&FMultiCollisionAnalytics::Analyze));
+
+static FAutoConsoleCommand ResetCommand(
+	TEXT("mc.Analytics.Reset"),
+	TEXT("Zero multi-collision components statistics."),
+	FConsoleCommandDelegate::CreateStatic(&FMultiCollisionAnalytics::Reset));
+
+void FMultiCollisionComponentStats::Add(const FMultiCollisionComponentStats& Other)
+{
+	Sweeps += Other.Sweeps;
+	BlockingHits += Other.BlockingHits;
+	Wins += Other.Wins;
+	Shadowed += Other.Shadowed;
+	Penetrations += Other.Penetrations;
+	Cycles += Other.Cycles;
+
+	if (ShadowedBy.Num() < Other.ShadowedBy.Num())
+	{
+		ShadowedBy.SetNumZeroed(Other.ShadowedBy.Num());
+	}
+	for (int32 i = 0; i < Other.ShadowedBy.Num(); i++)
+	{
+		ShadowedBy[i] += Other.ShadowedBy[i];
+	}
+}
+
+bool FMultiCollisionAnalytics::IsEnabled()
+{
+	return AnalyticsCVar != 0;
+}
+
+/** Statistics of one component name of one character class */
+struct FMultiCollisionAggregatedStats
+{
+	FString CharacterClass;
+	FString Component;
+	int32 Instances;
+	FMultiCollisionComponentStats Stats;
+
+	/** Component names of the character, ShadowedBy indices refer to them */
+	TArray<FString> ComponentNames;
+
+	FMultiCollisionAggregatedStats() : Instances(0) {}
+
+	/** Analysis result: empty, NeverBlocks or AlwaysShadowed */
+	FString GetFlag() const
+	{
+		if (Stats.Sweeps < AnalyticsMinSweepsCVar)
+		{
+			return FString();
+		}
+
+		if (Stats.BlockingHits == 0)
+		{
+			return TEXT("NeverBlocks");
+		}
+
+		if (Stats.Wins == 0)
+		{
+			return TEXT("AlwaysShadowed");
+		}
+
+		return FString();
+	}
+
+	/** Neighbour which shadowed the component most */
+	FString GetMainShadow() const
+	{
+		int32 MainIndex = INDEX_NONE;
+		for (int32 i = 0; i < Stats.ShadowedBy.Num(); i++)
+		{
+			if (Stats.ShadowedBy[i] > 0 && (MainIndex == INDEX_NONE || Stats.ShadowedBy[i] > Stats.ShadowedBy[MainIndex]))
+			{
+				MainIndex = i;
+			}
+		}
+
+		return ComponentNames.IsValidIndex(MainIndex) ? ComponentNames[MainIndex] : FString();
+	}
+};
+
+/** Statistics of movers which ended play or collected their components again */
+static TArray<FMultiCollisionAggregatedStats> RetiredRows;
+static TMap<FString, int32> RetiredRowIndices;
+
+/**
+ * Add statistics of every additional component of the mover to the row of its character class and component name.
+ * Mover is counted as an instance once per row, retired rows which already count it are added to OutCountedRows.
+ */
+static void AddMoverStats(TArray<FMultiCollisionAggregatedStats>& Rows, TMap<FString, int32>& RowIndices, const UMultiCollisionMovementComponent* Mover, TSet<FString>* OutCountedRows)
+{
+	const FString CharacterClass = Mover->GetOwner()->GetClass()->GetName();
+	const TArray<FMultiCollisionComponentStats>& ComponentStats = Mover->GetAdditionalComponentStats();
+
+	TArray<FString> ComponentNames;
+	Mover->GetAdditionalUpdatedComponentNames(ComponentNames);
+
+	for (int32 i = 0; i < ComponentStats.Num() && i < ComponentNames.Num(); i++)
+	{
+		const FString Key = CharacterClass + TEXT(".") + ComponentNames[i];
+		int32* RowIndex = RowIndices.Find(Key);
+		if (!RowIndex)
+		{
+			FMultiCollisionAggregatedStats& Row = Rows[Rows.AddDefaulted()];
+			Row.CharacterClass = CharacterClass;
+			Row.Component = ComponentNames[i];
+			Row.ComponentNames = ComponentNames;
+			RowIndex = &RowIndices.Add(Key, Rows.Num() - 1);
+		}
+
+		if (!Mover->GetCountedStatsRows().Contains(Key))
+		{
+			Rows[*RowIndex].Instances++;
+			if (OutCountedRows)
+			{
+				OutCountedRows->Add(Key);
+			}
+		}
+
+		Rows[*RowIndex].Stats.Add(ComponentStats[i]);
+	}
+}
+
+static void AggregateStats(TArray<FMultiCollisionAggregatedStats>& OutStats)
+{
+	OutStats = RetiredRows;
+	TMap<FString, int32> RowIndices = RetiredRowIndices;
+
+	for (TObjectIterator<UMultiCollisionMovementComponent> It; It; ++It)
+	{
+		// movers which ended play are already in the retired rows
+		const UMultiCollisionMovementComponent* Mover = *It;
+		if (Mover->IsTemplate() || !Mover->GetOwner() || !Mover->HasBegunPlay())
+		{
+			continue;
+		}
+
+		AddMoverStats(OutStats, RowIndices, Mover, nullptr);
+	}
+}
+
+void FMultiCollisionAnalytics::RetireStats(UMultiCollisionMovementComponent* Mover)
+{
+	if (Mover && Mover->GetOwner())
+	{
+		// mover which collects its components again is counted once, live statistics after recollection don't count it again
+		AddMoverStats(RetiredRows, RetiredRowIndices, Mover, &Mover->GetCountedStatsRows());
+	}
+}
+
+bool FMultiCollisionAnalytics::DumpCSV(const FString& Filename, FString& OutFilename)
+{
+	TArray<FMultiCollisionAggregatedStats> Rows;
+	AggregateStats(Rows);
+
+	FString CSV = TEXT("CharacterClass,Component,Instances,Sweeps,BlockingHits,Wins,Shadowed,Penetrations,TimeMs,AverageUs,Flag,MainShadow\n");
+	for (int32 i = 0; i < Rows.Num(); i++)
+	{
+		const FMultiCollisionAggregatedStats& Row = Rows[i];
+		const double TimeMs = FPlatformTime::ToMilliseconds64(Row.Stats.Cycles);
+		const double AverageUs = Row.Stats.Sweeps > 0 ? TimeMs * 1000.0 / Row.Stats.Sweeps : 0.0;
+
+		CSV += FString::Printf(TEXT("%s,%s,%d,%lld,%lld,%lld,%lld,%lld,%.3f,%.3f,%s,%s\n"), *Row.CharacterClass, *Row.Component, Row.Instances,
+			Row.Stats.Sweeps, Row.Stats.BlockingHits, Row.Stats.Wins, Row.Stats.Shadowed, Row.Stats.Penetrations, TimeMs, AverageUs, *Row.GetFlag(), *Row.GetMainShadow());
+	}
+
+	OutFilename = Filename.IsEmpty()
+		? FPaths::ProjectSavedDir() / TEXT("Profiling") / FString::Printf(TEXT("MultiCollisionAnalytics_%s.csv"), *FDateTime::Now().ToString())
+		: Filename;
+
+	return FFileHelper::SaveStringToFile(CSV, *OutFilename);
+}
+
+void FMultiCollisionAnalytics::Analyze()
+{
+	TArray<FMultiCollisionAggregatedStats> Rows;
+	AggregateStats(Rows);
+
+	int32 NumFlagged = 0;
+	for (int32 i = 0; i < Rows.Num(); i++)
+	{
+		const FMultiCollisionAggregatedStats& Row = Rows[i];
+		const FString Flag = Row.GetFlag();
+		if (Flag.IsEmpty())
+		{
+			continue;
+		}
+
+		NumFlagged++;
+		UE_LOG(LogMultiCollisionAnalytics, Display, TEXT("%s %s: %s (sweeps %lld, blocking hits %lld, main shadow %s)"), *Row.CharacterClass, *Row.Component, *Flag, Row.Stats.Sweeps, Row.Stats.BlockingHits, *Row.GetMainShadow());
+	}
+
+	UE_LOG(LogMultiCollisionAnalytics, Display, TEXT("%d of %d multi-collision components are candidates for removal"), NumFlagged, Rows.Num());
+}
+
+void FMultiCollisionAnalytics::Reset()
+{
+	RetiredRows.Reset();
+	RetiredRowIndices.Reset();
+
+	for (TObjectIterator<UMultiCollisionMovementComponent> It; It; ++It)
+	{
+		It->ResetAdditionalComponentStats();
+		It->GetCountedStatsRows().Reset();
+	}
+}
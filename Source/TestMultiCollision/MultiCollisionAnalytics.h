@@ -0,0 +1,52 @@
+#pragma once
+#include "CoreMinimal.h"
+
+class UMultiCollisionMovementComponent;
+
+/** Runtime statistics of one additional component, collected when mc.Analytics is enabled */
+struct FMultiCollisionComponentStats
+{
+	/** Number of simulated moves (sweeps) of the component */
+	int64 Sweeps;
+
+	/** Number of moves blocked by the component sweep */
+	int64 BlockingHits;
+
+	/** Number of moves where the component was the first blocked one (LastBlockedComponent) */
+	int64 Wins;
+
+	/** Number of moves where the component was blocked but another component was blocked earlier */
+	int64 Shadowed;
+
+	/** Number of blocking hits which started in penetration */
+	int64 Penetrations;
+
+	/** Time of the component sweeps, cycles */
+	uint64 Cycles;
+
+	/** How many times every other component shadowed this one, indices match additional components */
+	TArray<int32> ShadowedBy;
+
+	FMultiCollisionComponentStats() : Sweeps(0), BlockingHits(0), Wins(0), Shadowed(0), Penetrations(0), Cycles(0) {}
+
+	void Add(const FMultiCollisionComponentStats& Other);
+};
+
+/** Console commands and analysis of additional components statistics of all multi-collision movers */
+struct FMultiCollisionAnalytics
+{
+	/** True if mc.Analytics is enabled */
+	static bool IsEnabled();
+
+	/** Write statistics aggregated by character class and component name to CSV file, returns false if the file can't be written */
+	static bool DumpCSV(const FString& Filename, FString& OutFilename);
+
+	/** Log components which never block or are always shadowed by a neighbour */
+	static void Analyze();
+
+	/** Keep statistics of the mover which ends play or collects its components again, so destroyed movers are not lost for the analysis */
+	static void RetireStats(UMultiCollisionMovementComponent* Mover);
+
+	/** Zero statistics of all movers and forget retired statistics */
+	static void Reset();
+};
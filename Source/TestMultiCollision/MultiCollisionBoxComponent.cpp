@@ -0,0 +1,11 @@
+//#include "TestMultiCollision.h"
+#include "MultiCollisionBoxComponent.h"
+
+UMultiCollisionBoxComponent::UMultiCollisionBoxComponent(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
+{
+	BodyInstance.SetCollisionProfileName(FName("Pawn"));
+	bShouldUpdatePhysicsVolume = true;
+	CanCharacterStepUpOn = ECB_Yes;
+	SetNotifyRigidBodyCollision(false);
+	SetEnableGravity(false);
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include "Runtime/Engine/Classes/Components/BoxComponent.h"
+#include "MultiCollisionComponent.h"
+#include "MultiCollisionBoxComponent.generated.h"
+
+/** Implements the additional box component for movement sweep */
+UCLASS(NotBlueprintable, NotBlueprintType, ClassGroup = "Collision", editinlinenew, meta = (BlueprintSpawnableComponent))
+class UMultiCollisionBoxComponent : public UBoxComponent, public IMultiCollisionComponent
+{
+	GENERATED_BODY()
+	UMultiCollisionBoxComponent(const FObjectInitializer& ObjectInitializer);
+
+public:
+
+protected:
+
+
+private:
+
+
+};
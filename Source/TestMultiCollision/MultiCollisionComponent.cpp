@@ -0,0 +1,360 @@
+#include "MultiCollisionComponent.h"
+#include "MultiCollisionStaticCache.h"
+#include "Runtime/Engine/Classes/Components/PrimitiveComponent.h"
+#include "Runtime/Engine/Classes/Engine/World.h"
+#include "Runtime/Core/Public/Misc/Optional.h"
+
+static float InitialOverlapToleranceCVar = 0.0f;
+static FAutoConsoleVariableRef CVarInitialOverlapTolerance(
+	TEXT("p.InitialOverlapTolerance"),
+	InitialOverlapToleranceCVar,
+	TEXT("Tolerance for initial overlapping test in PrimitiveComponent movement.\n")
+	TEXT("Normals within this tolerance are ignored if moving out of the object.\n")
+	TEXT("Dot product of movement direction and surface normal."),
+	ECVF_Default);
+
+static void PullBackHit(FHitResult& Hit, const FVector& Start, const FVector& End, const float Dist)
+{
+	const float DesiredTimeBack = FMath::Clamp(0.1f, 0.1f / Dist, 1.f / Dist) + 0.001f;
+	Hit.Time = FMath::Clamp(Hit.Time - DesiredTimeBack, 0.f, 1.f);
+}
+
+// Stable order of hits which doesn't depend on the order of scene query results: by time and then by impact location and normal
+static bool IsHitBefore(const FHitResult& A, const FHitResult& B)
+{
+	if (A.Time != B.Time)
+	{
+		return A.Time < B.Time;
+	}
+
+	for (int32 Axis = 0; Axis < 3; Axis++)
+	{
+		if (A.ImpactPoint[Axis] != B.ImpactPoint[Axis])
+		{
+			return A.ImpactPoint[Axis] < B.ImpactPoint[Axis];
+		}
+	}
+
+	for (int32 Axis = 0; Axis < 3; Axis++)
+	{
+		if (A.ImpactNormal[Axis] != B.ImpactNormal[Axis])
+		{
+			return A.ImpactNormal[Axis] < B.ImpactNormal[Axis];
+		}
+	}
+
+	return false;
+}
+
+static bool ShouldIgnoreHitResult(const UWorld* InWorld, FHitResult const& TestHit, FVector const& MovementDirDenormalized, const AActor* MovingActor, EMoveComponentFlags MoveFlags)
+{
+	if (TestHit.bBlockingHit)
+	{
+		// check "ignore bases" functionality
+		if ((MoveFlags & MOVECOMP_IgnoreBases) && MovingActor)	//we let overlap components go through because their overlap is still needed and will cause beginOverlap/endOverlap events
+		{
+			// ignore if there's a base relationship between moving actor and hit actor
+			AActor const* const HitActor = TestHit.GetActor();
+			if (HitActor)
+			{
+				if (MovingActor->IsBasedOnActor(HitActor) || HitActor->IsBasedOnActor(MovingActor))
+				{
+					return true;
+				}
+			}
+		}
+
+		// If we started penetrating, we may want to ignore it if we are moving out of penetration.
+		// This helps prevent getting stuck in walls.
+		if (TestHit.bStartPenetrating && !(MoveFlags & MOVECOMP_NeverIgnoreBlockingOverlaps))
+		{
+			const float DotTolerance = InitialOverlapToleranceCVar;
+
+			// Dot product of movement direction against 'exit' direction
+			const FVector MovementDir = MovementDirDenormalized.GetSafeNormal();
+			const float MoveDot = (TestHit.ImpactNormal | MovementDir);
+
+			const bool bMovingOut = MoveDot > DotTolerance;
+
+			// If we are moving out, ignore this result!
+			if (bMovingOut)
+			{
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+void IMultiCollisionComponent::InitQueryFilter(const UPrimitiveComponent* Component, FMultiCollisionQueryFilter& OutFilter, ECollisionChannel MoverObjectType)
+{
+	OutFilter.QueryParams = FComponentQueryParams(TEXT("SimulateMoveComponent"), Component->GetOwner());
+	Component->InitSweepCollisionParams(OutFilter.QueryParams, OutFilter.ResponseParams);
+
+	// registered movers are filtered out of the world query by their object type and resolved from the mover grid
+	OutFilter.WorldResponseParams = OutFilter.ResponseParams;
+	if (MoverObjectType < ECC_OverlapAll_Deprecated)
+	{
+		OutFilter.WorldResponseParams.CollisionResponse.SetResponse(MoverObjectType, ECR_Ignore);
+	}
+
+	OutFilter.DynamicQueryParams = OutFilter.QueryParams;
+	OutFilter.DynamicQueryParams.MobilityType = EQueryMobilityType::Dynamic;
+
+	OutFilter.MoveIgnoreActors = Component->MoveIgnoreActors;
+
+	OutFilter.ObjectType = Component->GetCollisionObjectType();
+
+	// component which doesn't block any channel or has no query collision can't be blocked by the sweep
+	OutFilter.bCanBlock = false;
+	if (Component->IsQueryCollisionEnabled())
+	{
+		// EnumArray has 32 channels, ECC_OverlapAll_Deprecated and ECC_MAX are past its end
+		for (int32 Channel = 0; Channel < ECC_OverlapAll_Deprecated; Channel++)
+		{
+			if (OutFilter.ResponseParams.CollisionResponse.GetResponse((ECollisionChannel)Channel) == ECR_Block)
+			{
+				OutFilter.bCanBlock = true;
+				break;
+			}
+		}
+	}
+}
+
+FBox IMultiCollisionComponent::GetSweepBox(const FVector& Start, const FVector& End, const FCollisionShape& Shape)
+{
+	FBox SweepBox(ForceInit);
+	SweepBox += Start;
+	SweepBox += End;
+	return SweepBox.ExpandBy(Shape.GetExtent().GetMax());
+}
+
+bool IMultiCollisionComponent::ShouldBlock(const UPrimitiveComponent* SweptComponent, const UPrimitiveComponent* OtherComponent)
+{
+	if (!OtherComponent || !OtherComponent->IsQueryCollisionEnabled())
+	{
+		return false;
+	}
+
+	// the same rule as the world query uses: both should block each other
+	if (SweptComponent->GetCollisionResponseToChannel(OtherComponent->GetCollisionObjectType()) != ECR_Block || OtherComponent->GetCollisionResponseToChannel(SweptComponent->GetCollisionObjectType()) != ECR_Block)
+	{
+		return false;
+	}
+
+	const AActor* OtherOwner = OtherComponent->GetOwner();
+	if (OtherOwner && (OtherOwner == SweptComponent->GetOwner() || SweptComponent->MoveIgnoreActors.Contains(OtherOwner)))
+	{
+		return false;
+	}
+
+	// ignored components and the ignore mask are the rest of the query params the world query filters by
+	if (SweptComponent->GetMoveIgnoreComponents().Contains(OtherComponent) || (SweptComponent->GetMoveIgnoreMask() & OtherComponent->GetMaskFilter()) != 0)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+bool IMultiCollisionComponent::SweepAgainstComponent(FHitResult& OutHit, const UPrimitiveComponent* SweptComponent, UPrimitiveComponent* OtherComponent, const FBox& SweepBox, const FVector& Start, const FVector& End, const FQuat& Rotation, const FCollisionShape& Shape)
+{
+	if (!ShouldBlock(SweptComponent, OtherComponent))
+	{
+		return false;
+	}
+
+	if (!SweepBox.Intersect(OtherComponent->Bounds.GetBox()))
+	{
+		return false;
+	}
+
+	if (!OtherComponent->SweepComponent(OutHit, Start, End, Rotation, Shape, OtherComponent->bTraceComplexOnMove))
+	{
+		return false;
+	}
+
+	OutHit.bBlockingHit = true;
+	return true;
+}
+
+FMultiCollisionContact::FMultiCollisionContact()
+	: Time(1.f)
+	, bStartPenetrating(false)
+	, ComponentIndex(INDEX_NONE)
+	, HitIndex(INDEX_NONE)
+{
+
+}
+
+void FMultiCollisionContact::ExpandHitResult(const TArray<FHitResult>& Hits, FHitResult& OutHit) const
+{
+	if (Hits.IsValidIndex(HitIndex))
+	{
+		OutHit = Hits[HitIndex];
+	}
+	else
+	{
+		OutHit.Init(); // contact without hit, simulation was skipped
+	}
+}
+
+// this is a simitation of UPrimitiveComponent::MoveComponentImpl() without actual move, just sweep checks
+bool IMultiCollisionComponent::SimulateMoveComponent(UPrimitiveComponent* Component, const USceneComponent* CharacterRootComponent, const FVector& NewDelta, const FQuat& NewRotation, TArray<FHitResult>& Hits, FMultiCollisionContact& OutContact, EMoveComponentFlags MoveFlags, const FMultiCollisionSweepContext* SweepContext, const FMultiCollisionQueryFilter* QueryFilter)
+{
+	OutContact = FMultiCollisionContact();
+
+	// static things can move before they are registered (e.g. immediately after streaming), but not after.
+	if (Component->IsPendingKill() || !Component->IsRegistered() || !Component->GetWorld())
+	{
+		Hits.Reset();
+		return false; // skip simulation
+	}
+
+	Component->ConditionalUpdateComponentToWorld();
+
+	// Additional component attached to te socket and has relative rotation, so the root rotation != additional component rotation
+	// We need to find new additional component rotation which will be with NewRotationQuat applied to root component.
+	const FQuat DeltaQuat = NewRotation * CharacterRootComponent->GetComponentQuat().Inverse(); // find delta rotation of the root component
+	const FQuat NewCompQuat = DeltaQuat * Component->GetComponentQuat(); // calc new rotation for this component
+
+	// debug
+	// UE_LOG(LogClass, Log, TEXT("							SimulateMoveComponent %s ROT Current %s New = %s"), *GetNameSafe(Component->GetOwner()), *Component->GetComponentQuat().Rotator().ToString(), *NewCompQuat.Rotator().ToString());
+	// debug
+
+	// Additional component has translation from the root component. That means any turn of the root is also the location change for additional component
+	const FVector RootComponentLocation = CharacterRootComponent->GetComponentLocation();
+
+	const FVector TraceStart = Component->GetComponentLocation();
+
+	// In modular system component can not be attached directly to the root component, and can be attached to the child of the child of the child
+	// This means we can not find relative translation directly from transform
+	// For this component we need to find translation from the root center and calc new location on new root rotation
+	const FVector DeltaLocation = TraceStart - RootComponentLocation;
+	const FVector DeltaDir = DeltaLocation.GetSafeNormal();
+	const float DeltaSize = DeltaLocation.Size();
+	const FVector NewDir = DeltaQuat.RotateVector(DeltaDir); // turn direction vector on delta rotation
+	const FVector NewComponentLocation = RootComponentLocation + NewDir * DeltaSize;
+
+	const FVector TraceEnd = NewComponentLocation + NewDelta;
+
+	// debug
+	// UE_LOG(LogClass, Log, TEXT("							SimulateMoveComponent %s Loc Current %s New = %s"), *GetNameSafe(Component->GetOwner()), *TraceStart.ToString(), *TraceEnd.ToString());
+	// debug
+
+	// hits buffer is owned by the caller and keeps its allocation between moves
+	Hits.Reset();
+
+	// precomputed filter is used as is, params are built here only without the filter
+	TOptional<FMultiCollisionQueryFilter> LocalFilter;
+	if (!QueryFilter)
+	{
+		LocalFilter.Emplace();
+		InitQueryFilter(Component, LocalFilter.GetValue());
+		QueryFilter = &LocalFilter.GetValue();
+	}
+
+	const FMultiCollisionQueryFilter& Filter = *QueryFilter;
+
+	bool bHadBlockingHit = false;
+
+	// with the cache static geometry is swept directly below, so the world query is needed only for movable objects
+	const FMultiCollisionStaticCache* StaticCache = SweepContext ? SweepContext->StaticCache : nullptr;
+	const FComponentQueryParams* QueryParams = StaticCache ? &Filter.DynamicQueryParams : &Filter.QueryParams;
+
+	// other movers of the grid are not in the world query responses, their collision components are swept directly below
+	const bool bSweepNearbyMovers = SweepContext && SweepContext->NearbyMoverComponents.Num() > 0;
+
+	bHadBlockingHit = Component->GetWorld()->SweepMultiByChannel(Hits, TraceStart, TraceEnd, NewCompQuat, Filter.ObjectType, Component->GetCollisionShape(), *QueryParams, Filter.WorldResponseParams);
+
+	const int32 NumWorldHits = Hits.Num();
+
+	if (StaticCache)
+	{
+		StaticCache->Sweep(Hits, Component, TraceStart, TraceEnd, NewCompQuat, Component->GetCollisionShape());
+	}
+
+	if (bSweepNearbyMovers)
+	{
+		const FCollisionShape Shape = Component->GetCollisionShape();
+		const FBox SweepBox = GetSweepBox(TraceStart, TraceEnd, Shape);
+		for (int32 i = 0; i < SweepContext->NearbyMoverComponents.Num(); i++)
+		{
+			FHitResult MoverHit(1.f);
+			if (SweepAgainstComponent(MoverHit, Component, SweepContext->NearbyMoverComponents[i], SweepBox, TraceStart, TraceEnd, NewCompQuat, Shape))
+			{
+				Hits.Add(MoverHit);
+			}
+		}
+	}
+
+	if (Hits.Num() > NumWorldHits)
+	{
+		// world, cache and movers hits are merged, so restore the order by time which is expected by the blocking hit selection below
+		bHadBlockingHit = true;
+		Hits.Sort([](const FHitResult& A, const FHitResult& B) { return IsHitBefore(A, B); });
+	}
+
+	if (Hits.Num() > 0)
+	{
+		const float NewDeltaSize = NewDelta.Size();
+		for (int32 HitIdx = 0; HitIdx < Hits.Num(); HitIdx++)
+		{
+			PullBackHit(Hits[HitIdx], TraceStart, TraceEnd, NewDeltaSize);
+		}
+	}
+
+	if (bHadBlockingHit)
+	{
+		int32 BlockingHitIndex = INDEX_NONE;
+		float BlockingHitNormalDotDelta = BIG_NUMBER;
+		for (int32 HitIdx = 0; HitIdx < Hits.Num(); HitIdx++)
+		{
+			const FHitResult& TestHit = Hits[HitIdx];
+
+			if (TestHit.bBlockingHit)
+			{
+				if (!ShouldIgnoreHitResult(Component->GetWorld(), TestHit, NewDelta, Component->GetOwner(), MoveFlags))
+				{
+					if (TestHit.Time == 0.f)
+					{
+						// We may have multiple initial hits, and want to choose the one with the normal most opposed to our movement.
+						const float NormalDotDelta = (TestHit.ImpactNormal | NewDelta);
+						// equal normals are resolved by stable hit order, so the result doesn't depend on scene query order
+						if (NormalDotDelta < BlockingHitNormalDotDelta || (NormalDotDelta == BlockingHitNormalDotDelta && BlockingHitIndex != INDEX_NONE && IsHitBefore(TestHit, Hits[BlockingHitIndex])))
+						{
+							BlockingHitNormalDotDelta = NormalDotDelta;
+							BlockingHitIndex = HitIdx;
+						}
+					}
+					else if (BlockingHitIndex == INDEX_NONE)
+					{
+						// First non-overlapping blocking hit should be used, if an overlapping hit was not.
+						// This should be the only non-overlapping blocking hit, and last in the results.
+						BlockingHitIndex = HitIdx;
+						break;
+					}
+				}
+			}
+		}
+
+		// Update blocking hit, if there was a valid one.
+		if (BlockingHitIndex >= 0)
+		{
+			// only the compact contact goes out, full hit stays in the buffer until the winner of all components is selected
+			const FHitResult& BlockingHit = Hits[BlockingHitIndex];
+			OutContact.Time = BlockingHit.Time;
+			OutContact.bStartPenetrating = BlockingHit.bStartPenetrating;
+			OutContact.HitIndex = BlockingHitIndex;
+
+			return false;
+		}
+		else
+		{
+			return true;
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include "Runtime/CoreUObject/Public/UObject/Interface.h"
+#include "Runtime/Engine/Classes/Engine/EngineTypes.h"
+#include "Runtime/Engine/Public/CollisionQueryParams.h"
+#include "MultiCollisionComponent.generated.h"
+
+/** World data shared by sweeps of all additional components in one move */
+struct FMultiCollisionSweepContext
+{
+	/** Static geometry around the character, null if static geometry is tested by the world query */
+	const struct FMultiCollisionStaticCache* StaticCache;
+
+	/** Collision components of other multi-collision movers near the move. They have the mover grid object type which the world query ignores, so they are tested only by direct sweeps. */
+	TArray<class UPrimitiveComponent*> NearbyMoverComponents;
+
+	FMultiCollisionSweepContext() : StaticCache(nullptr) {}
+
+	void Reset()
+	{
+		StaticCache = nullptr;
+		NearbyMoverComponents.Reset();
+	}
+};
+
+/** Sweep query params of one additional component, precomputed once by the movement component instead of every move */
+struct FMultiCollisionQueryFilter
+{
+	FComponentQueryParams QueryParams;
+	FCollisionResponseParams ResponseParams;
+
+	/** ResponseParams of the world query, the object type of movers registered in the mover grid is ignored because they are swept directly */
+	FCollisionResponseParams WorldResponseParams;
+
+	/** QueryParams which skip static and stationary geometry, used with the static geometry cache */
+	FComponentQueryParams DynamicQueryParams;
+
+	/** Ignored actors of the component the params were built with, the filter is built again when they change */
+	TArray<class AActor*> MoveIgnoreActors;
+
+	ECollisionChannel ObjectType;
+
+	/** False if the component doesn't block anything (sensor, no query collision), its sweep can be skipped */
+	bool bCanBlock;
+
+	/** Index of the group of components with the same object type and responses */
+	int32 GroupIndex;
+
+	FMultiCollisionQueryFilter() : ObjectType(ECC_Pawn), bCanBlock(true), GroupIndex(INDEX_NONE) {}
+};
+
+/** Compact record of the blocking hit of one additional component. Full FHitResult stays in the sweep hits buffer and is expanded only for the selected hit. */
+struct FMultiCollisionContact
+{
+	float Time;
+	bool bStartPenetrating;
+
+	/** Index of the additional component which was blocked, set by the movement component */
+	int32 ComponentIndex;
+
+	/** Index of the full hit in the hits buffer of the component, INDEX_NONE if simulation was skipped */
+	int32 HitIndex;
+
+	FMultiCollisionContact();
+
+	/** Copy the full hit from the hits buffer the contact was made from */
+	void ExpandHitResult(const TArray<FHitResult>& Hits, FHitResult& OutHit) const;
+};
+
+UINTERFACE(meta = (CannotImplementInterfaceInBlueprint))
+class UMultiCollisionComponent : public UInterface
+{
+	GENERATED_BODY()
+};
+
+/** Implemented by additional collision components of multi-collision character which are swept on movement instead of the root component */
+class IMultiCollisionComponent
+{
+	GENERATED_BODY()
+
+public:
+	/** Shared simulation of the move of any additional component shape (capsule, box, sphere). Gives the compact contact of the blocking hit, Hits is the reusable buffer the contact refers to. */
+	static bool SimulateMoveComponent(class UPrimitiveComponent* Component, const class USceneComponent* CharacterRootComponent, const FVector& NewDelta, const FQuat& NewRotation, TArray<FHitResult>& Hits, FMultiCollisionContact& OutContact, EMoveComponentFlags MoveFlags = MOVECOMP_NoFlags, const FMultiCollisionSweepContext* SweepContext = nullptr, const FMultiCollisionQueryFilter* QueryFilter = nullptr);
+
+	/** Build sweep query params of the component. MoverObjectType is the object type of movers registered in the mover grid, ECC_MAX if the grid is not used. */
+	static void InitQueryFilter(const class UPrimitiveComponent* Component, FMultiCollisionQueryFilter& OutFilter, ECollisionChannel MoverObjectType = ECC_MAX);
+
+	/** True if SweptComponent and OtherComponent block each other and OtherComponent is not ignored by the move, the same rule as the world query uses */
+	static bool ShouldBlock(const class UPrimitiveComponent* SweptComponent, const class UPrimitiveComponent* OtherComponent);
+
+	/** Sweep the shape of SweptComponent against OtherComponent directly without the world query. Returns true and the blocking hit if both components block each other. */
+	static bool SweepAgainstComponent(FHitResult& OutHit, const class UPrimitiveComponent* SweptComponent, class UPrimitiveComponent* OtherComponent, const FBox& SweepBox, const FVector& Start, const FVector& End, const FQuat& Rotation, const FCollisionShape& Shape);
+
+	/** Bounds of the whole sweep of the shape */
+	static FBox GetSweepBox(const FVector& Start, const FVector& End, const FCollisionShape& Shape);
+};
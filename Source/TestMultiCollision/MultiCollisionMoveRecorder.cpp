@@ -0,0 +1,132 @@
+#include "MultiCollisionMoveRecorder.h"
+#include "HAL/FileManager.h"
+
+FArchive& operator<<(FArchive& Ar, FMultiCollisionMoveStreamHeader& Header)
+{
+	Ar << Header.Magic;
+	Ar << Header.Version;
+	Ar << Header.MapName;
+
+	// old stream is rejected by the reader after the header, so it should not read the fields it doesn't have
+	if (Header.Version >= 2)
+	{
+		Ar << Header.StreamingLevels;
+	}
+
+	Ar << Header.CharacterClass;
+	Ar << Header.ComponentNames;
+	return Ar;
+}
+
+FMultiCollisionMoveRecord::FMultiCollisionMoveRecord()
+	: Frame(0)
+	, StartLocation(FVector::ZeroVector)
+	, StartRotation(FQuat::Identity)
+	, Delta(FVector::ZeroVector)
+	, Rotation(FQuat::Identity)
+	, bSweep(false)
+	, MoveFlags(MOVECOMP_NoFlags)
+	, bMoved(true)
+	, EndLocation(FVector::ZeroVector)
+	, HitTime(1.f)
+	, HitNormal(FVector::ZeroVector)
+	, HitImpactPoint(FVector::ZeroVector)
+	, bStartPenetrating(false)
+	, BlockedComponentIndex(INDEX_NONE)
+{
+
+}
+
+FArchive& operator<<(FArchive& Ar, FMultiCollisionMoveRecord& Record)
+{
+	// bools are packed to one byte to keep records compact
+	uint8 Bits = (Record.bSweep ? 1 : 0) | (Record.bMoved ? 2 : 0) | (Record.bStartPenetrating ? 4 : 0);
+
+	Ar << Record.Frame;
+	Ar << Record.StartLocation;
+	Ar << Record.StartRotation;
+	Ar << Record.Delta;
+	Ar << Record.Rotation;
+	Ar << Bits;
+	Ar << Record.MoveFlags;
+	Ar << Record.EndLocation;
+	Ar << Record.HitTime;
+	Ar << Record.HitNormal;
+	Ar << Record.HitImpactPoint;
+	Ar << Record.BlockedComponentIndex;
+
+	if (Ar.IsLoading())
+	{
+		Record.bSweep = (Bits & 1) != 0;
+		Record.bMoved = (Bits & 2) != 0;
+		Record.bStartPenetrating = (Bits & 4) != 0;
+	}
+
+	return Ar;
+}
+
+FMultiCollisionMoveRecorder::~FMultiCollisionMoveRecorder()
+{
+	Close();
+}
+
+bool FMultiCollisionMoveRecorder::Open(const FString& Filename, FMultiCollisionMoveStreamHeader& Header)
+{
+	Close();
+
+	Writer.Reset(IFileManager::Get().CreateFileWriter(*Filename));
+	if (!Writer.IsValid())
+	{
+		return false;
+	}
+
+	*Writer << Header;
+	return true;
+}
+
+void FMultiCollisionMoveRecorder::Close()
+{
+	if (Writer.IsValid())
+	{
+		Writer->Close();
+		Writer.Reset();
+	}
+}
+
+void FMultiCollisionMoveRecorder::Record(FMultiCollisionMoveRecord& Record)
+{
+	if (Writer.IsValid())
+	{
+		*Writer << Record;
+	}
+}
+
+bool FMultiCollisionMoveReader::Open(const FString& Filename, FMultiCollisionMoveStreamHeader& OutHeader)
+{
+	Reader.Reset(IFileManager::Get().CreateFileReader(*Filename));
+	if (!Reader.IsValid())
+	{
+		return false;
+	}
+
+	*Reader << OutHeader;
+
+	if (Reader->IsError() || OutHeader.Magic != FMultiCollisionMoveStreamHeader::StreamMagic || OutHeader.Version != FMultiCollisionMoveStreamHeader::StreamVersion)
+	{
+		Reader.Reset();
+		return false;
+	}
+
+	return true;
+}
+
+bool FMultiCollisionMoveReader::Read(FMultiCollisionMoveRecord& OutRecord)
+{
+	if (!Reader.IsValid() || Reader->AtEnd())
+	{
+		return false;
+	}
+
+	*Reader << OutRecord;
+	return !Reader->IsError();
+}
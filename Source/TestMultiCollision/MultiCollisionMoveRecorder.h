@@ -0,0 +1,99 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "Runtime/Engine/Classes/Engine/EngineTypes.h"
+
+/** Header of the move stream, written once at the beginning of the file */
+struct FMultiCollisionMoveStreamHeader
+{
+	enum { StreamMagic = 0x564D434D }; // "MCMV"
+	enum { StreamVersion = 2 };
+
+	uint32 Magic;
+	int32 Version;
+
+	/** Package name of the level where moves were recorded */
+	FString MapName;
+
+	/** Package names of streaming levels which were visible when the stream was opened, replay makes the same levels visible */
+	TArray<FString> StreamingLevels;
+
+	/** Path of the recorded character class, replay spawns the same class */
+	FString CharacterClass;
+
+	/** Names of additional updated components, blocked component in records is an index in this array */
+	TArray<FString> ComponentNames;
+
+	FMultiCollisionMoveStreamHeader() : Magic(StreamMagic), Version(StreamVersion) {}
+
+	friend FArchive& operator<<(FArchive& Ar, FMultiCollisionMoveStreamHeader& Header);
+};
+
+/** Inputs and result of one UMultiCollisionMovementComponent::MoveUpdatedComponentImpl() call */
+struct FMultiCollisionMoveRecord
+{
+	/** Frame number of the move, several moves can be done in one frame */
+	uint32 Frame;
+
+	/** Updated component transform before the move */
+	FVector StartLocation;
+	FQuat StartRotation;
+
+	/** Move inputs */
+	FVector Delta;
+	FQuat Rotation;
+	bool bSweep;
+	uint8 MoveFlags;
+
+	/** Move result */
+	bool bMoved;
+	FVector EndLocation;
+	float HitTime;
+	FVector HitNormal;
+	FVector HitImpactPoint;
+	bool bStartPenetrating;
+
+	/** Index of LastBlockedComponent in stream header ComponentNames, INDEX_NONE if nothing blocked */
+	int32 BlockedComponentIndex;
+
+	FMultiCollisionMoveRecord();
+
+	friend FArchive& operator<<(FArchive& Ar, FMultiCollisionMoveRecord& Record);
+};
+
+/** Streaming writer of move records for one character */
+class FMultiCollisionMoveRecorder
+{
+public:
+
+	~FMultiCollisionMoveRecorder();
+
+	/** Create the stream file and write the header */
+	bool Open(const FString& Filename, FMultiCollisionMoveStreamHeader& Header);
+
+	/** Flush and close the stream file */
+	void Close();
+
+	bool IsOpen() const { return Writer.IsValid(); }
+
+	void Record(FMultiCollisionMoveRecord& Record);
+
+private:
+
+	TUniquePtr<FArchive> Writer;
+};
+
+/** Streaming reader of move records, used by replay */
+class FMultiCollisionMoveReader
+{
+public:
+
+	/** Open the stream file and read the header, fails on unknown file or version */
+	bool Open(const FString& Filename, FMultiCollisionMoveStreamHeader& OutHeader);
+
+	/** Read next record, returns false at the end of the stream */
+	bool Read(FMultiCollisionMoveRecord& OutRecord);
+
+private:
+
+	TUniquePtr<FArchive> Reader;
+};
@@ -1,13 +1,50 @@
 #include "MultiCollisionMovementComponent.h"
-#include "MultiCollisionCapsuleComponent.h"
+#include "MultiCollisionComponent.h"
 #include "MultiCollisionCharacter.h"
+#include "MultiCollisionMoverGrid.h"
+#include "MultiCollisionScheduler.h"
 
 #include "Runtime/Engine/Classes/GameFramework/PhysicsVolume.h"
+#include "Runtime/Engine/Classes/Engine/World.h"
+#include "Runtime/Engine/Classes/Engine/LevelStreaming.h"
+#include "Runtime/Core/Public/Misc/Paths.h"
+
+static int32 RecordMovesCVar = 0;
+static FAutoConsoleVariableRef CVarRecordMoves(
+	TEXT("mc.RecordMoves"),
+	RecordMovesCVar,
+	TEXT("Record moves of multi-collision characters to Saved/MultiCollision/*.mcmove streams.\n")
+	TEXT("Streams can be replayed with -run=MultiCollisionReplay commandlet.\n")
+	TEXT("0: off, 1: on"),
+	ECVF_Default);
 
 
 UMultiCollisionMovementComponent::UMultiCollisionMovementComponent(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
 {
 	PenetrationOverlapCheckInflation = 0.1f;
+	bUseStaticGeometryCache = false;
+	StaticGeometryCacheMargin = 1000.f;
+	bUseMoverGrid = false;
+	MoverGridObjectType = ECC_GameTraceChannel1;
+	bUseQueryGroupPreTest = false;
+	bDeterministicSimulation = false;
+	FixedTimeStep = 1.f / 60.f;
+	MaxFixedTimeSteps = 4;
+	FixedTimeAccumulator = 0.f;
+	FixedStepInputVector = FVector::ZeroVector;
+	bInFixedStepTick = false;
+	bInPhysicsSubstep = false;
+	bAlwaysUpdateMovement = false;
+	ScheduledTimeAccumulator = 0.f;
+	ScheduledSubstepTime = 0.f;
+	bEnableDormancy = false;
+	DormancyFrames = 30;
+	bDormant = false;
+	StationaryFrames = 0;
+	LastTickRotation = FQuat::Identity;
+	LastTickLocation = FVector::ZeroVector;
+	LastTickGravityZ = 0.f;
+	NumMoveStreams = 0;
 
 }
 
@@ -16,6 +53,302 @@ void UMultiCollisionMovementComponent::InitializeComponent()
 	Super::InitializeComponent();
 }
 
+void UMultiCollisionMovementComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (bUseMoverGrid && GetWorld())
+	{
+		FMultiCollisionMoverGrid::Get(GetWorld()).Register(this);
+	}
+}
+
+void UMultiCollisionMovementComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (bUseMoverGrid)
+	{
+		FMultiCollisionMoverGrid::Unregister(GetWorld(), this);
+	}
+
+	FMultiCollisionScheduler::Unregister(GetWorld(), this);
+
+	// statistics of destroyed mover stay for the analysis after the playtest
+	FMultiCollisionAnalytics::RetireStats(this);
+	ResetAdditionalComponentStats();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+FBox UMultiCollisionMovementComponent::GetMoverBounds() const
+{
+	FBox MoverBounds(ForceInit);
+	for (int32 i = 0; i < AdditionalUpdatedComponents.Num(); i++)
+	{
+		if (AdditionalUpdatedComponents[i] && AdditionalUpdatedComponents[i]->IsQueryCollisionEnabled())
+		{
+			MoverBounds += AdditionalUpdatedComponents[i]->Bounds.GetBox();
+		}
+	}
+
+	if (UpdatedPrimitive && UpdatedPrimitive->IsQueryCollisionEnabled())
+	{
+		MoverBounds += UpdatedPrimitive->Bounds.GetBox();
+	}
+
+	return MoverBounds;
+}
+
+void UMultiCollisionMovementComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction)
+{
+	if (bDormant)
+	{
+		if (!ShouldWakeUp())
+		{
+			return; // no movement, no rotation and no overlaps update for dormant character
+		}
+
+		WakeUp();
+	}
+
+	// movers which are not player controlled and not significant wait for their turn inside the frame budget
+	const bool bScheduled = FMultiCollisionScheduler::IsEnabled() && ShouldScheduleMovement();
+	if (bScheduled)
+	{
+		ScheduledTimeAccumulator += DeltaTime;
+		if (!FMultiCollisionScheduler::Get(GetWorld()).ShouldUpdate(this, ScheduledTimeAccumulator))
+		{
+			return;
+		}
+
+		DeltaTime = ScheduledTimeAccumulator;
+		ScheduledTimeAccumulator = 0.f;
+	}
+	else
+	{
+		ScheduledTimeAccumulator = 0.f;
+
+		if (FMultiCollisionScheduler::IsEnabled())
+		{
+			// player controlled or significant mover doesn't hold a slot of the round robin window
+			FMultiCollisionScheduler::Get(GetWorld()).Remove(this);
+		}
+	}
+
+	int32 NumSteps = 1;
+	const bool bFixedSteps = ShouldUseFixedTimeSteps();
+	if (bFixedSteps)
+	{
+		// simulate only whole fixed steps, the rest of the frame time waits for the next tick
+		FixedTimeAccumulator += DeltaTime;
+		NumSteps = FMath::Min(FMath::FloorToInt(FixedTimeAccumulator / FixedTimeStep), MaxFixedTimeSteps);
+		FixedTimeAccumulator = FMath::Min(FixedTimeAccumulator - NumSteps * FixedTimeStep, FixedTimeStep);
+
+		if (NumSteps <= 0)
+		{
+			return;
+		}
+
+		// every step is the full engine update (input, acceleration, physics and rotation), so the trajectory doesn't depend on how frame times group the steps
+		DeltaTime = FixedTimeStep;
+		FixedStepInputVector = Super::ConsumeInputVector();
+	}
+
+	TGuardValue<bool> FixedStepTickGuard(bInFixedStepTick, bFixedSteps);
+
+	// accumulated time of scheduled mover is simulated with safe steps
+	TGuardValue<float> ScheduledSubstepGuard(ScheduledSubstepTime, bScheduled && DeltaTime > MaxSimulationTimeStep ? MaxSimulationTimeStep : 0.f);
+
+	const double StartTime = FPlatformTime::Seconds();
+	for (int32 Step = 0; Step < NumSteps; Step++)
+	{
+		Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	}
+
+	if (FMultiCollisionScheduler::IsEnabled())
+	{
+		FMultiCollisionScheduler::Get(GetWorld()).AddUpdateCost(FPlatformTime::Seconds() - StartTime, bScheduled);
+	}
+
+	UpdateDormancy();
+}
+
+bool UMultiCollisionMovementComponent::ShouldUseFixedTimeSteps() const
+{
+	if (!bDeterministicSimulation || FixedTimeStep <= 0.f || !HasValidData())
+	{
+		return false;
+	}
+
+	// locally controlled character or AI on the server, server side of remote player and simulated proxies are driven by the network
+	return CharacterOwner->IsLocallyControlled() || (CharacterOwner->Role == ROLE_Authority && !CharacterOwner->IsPlayerControlled());
+}
+
+FVector UMultiCollisionMovementComponent::ConsumeInputVector()
+{
+	// input is consumed once per tick, so every fixed step of the tick gets the same input
+	return bInFixedStepTick ? FixedStepInputVector : Super::ConsumeInputVector();
+}
+
+bool UMultiCollisionMovementComponent::ShouldScheduleMovement() const
+{
+	// deterministic simulation can't skip frames, it has its own time steps
+	if (bAlwaysUpdateMovement || bDeterministicSimulation || !HasValidData() || !GetWorld())
+	{
+		return false;
+	}
+
+	// only AI movers on the side which simulates them
+	return CharacterOwner->Role == ROLE_Authority && !CharacterOwner->IsPlayerControlled();
+}
+
+void UMultiCollisionMovementComponent::WakeUp()
+{
+	bDormant = false;
+	StationaryFrames = 0;
+}
+
+bool UMultiCollisionMovementComponent::ShouldWakeUp() const
+{
+	if (!HasValidData())
+	{
+		return false;
+	}
+
+	if (!Velocity.IsZero() || !CharacterOwner->GetPendingMovementInputVector().IsZero() || bHasRequestedVelocity)
+	{
+		return true;
+	}
+
+	if (!PendingImpulseToApply.IsZero() || !PendingForceToApply.IsZero() || !PendingLaunchVelocity.IsZero())
+	{
+		return true;
+	}
+
+	if (CharacterOwner->IsPlayingRootMotion() || CurrentRootMotion.HasActiveRootMotionSources())
+	{
+		return true;
+	}
+
+	// moving base moves the character, so it can't sleep on it
+	if (MovementBase && (MovementBase->IsPendingKill() || MovementBaseUtility::IsDynamicBase(MovementBase)))
+	{
+		return true;
+	}
+
+	// floor can lose its collision without being destroyed
+	if (IsMovingOnGround())
+	{
+		const UPrimitiveComponent* FloorComponent = CurrentFloor.HitResult.Component.Get();
+		if (!CurrentFloor.IsWalkableFloor() || !FloorComponent || !FloorComponent->IsRegistered() || !FloorComponent->IsQueryCollisionEnabled()
+			|| FloorComponent->GetCollisionResponseToChannel(UpdatedPrimitive->GetCollisionObjectType()) != ECR_Block)
+		{
+			return true;
+		}
+	}
+
+	// moved by SetActorLocation/SetActorRotation or gravity changed by physics volume, world or gravity scale
+	if (!UpdatedComponent->GetComponentLocation().Equals(LastTickLocation) || !UpdatedComponent->GetComponentQuat().Equals(LastTickRotation, SCENECOMPONENT_QUAT_TOLERANCE)
+		|| GetGravityZ() != LastTickGravityZ || GetPhysicsVolume() != LastTickPhysicsVolume.Get())
+	{
+		return true;
+	}
+
+	if (bUseControllerDesiredRotation && CharacterOwner->Controller)
+	{
+		FRotator DesiredRotation = CharacterOwner->Controller->GetDesiredRotation();
+		NormalizeDesiredRotation(DesiredRotation);
+
+		const float AngleTolerance = 1e-3f;
+		if (!UpdatedComponent->GetComponentRotation().Equals(DesiredRotation, AngleTolerance))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void UMultiCollisionMovementComponent::NormalizeDesiredRotation(FRotator& DesiredRotation) const
+{
+	if (ShouldRemainVertical())
+	{
+		DesiredRotation.Pitch = 0.f;
+		DesiredRotation.Yaw = FRotator::NormalizeAxis(DesiredRotation.Yaw);
+		DesiredRotation.Roll = 0.f;
+	}
+	else
+	{
+		DesiredRotation.Normalize();
+	}
+}
+
+void UMultiCollisionMovementComponent::OnTeleported()
+{
+	Super::OnTeleported();
+	WakeUp();
+}
+
+void UMultiCollisionMovementComponent::OnMovementModeChanged(EMovementMode PreviousMovementMode, uint8 PreviousCustomMode)
+{
+	Super::OnMovementModeChanged(PreviousMovementMode, PreviousCustomMode);
+	WakeUp();
+}
+
+void UMultiCollisionMovementComponent::UpdateDormancy()
+{
+	if (!bEnableDormancy || !HasValidData() || CharacterOwner->Role == ROLE_SimulatedProxy)
+	{
+		StationaryFrames = 0;
+		return;
+	}
+
+	// ShouldWakeUp() compares the transform with the previous tick, so a moved or turned character is not stationary
+	const bool bStationary = Acceleration.IsZero() && !ShouldWakeUp();
+	LastTickRotation = UpdatedComponent->GetComponentQuat();
+	LastTickLocation = UpdatedComponent->GetComponentLocation();
+	LastTickGravityZ = GetGravityZ();
+	LastTickPhysicsVolume = GetPhysicsVolume();
+
+	StationaryFrames = bStationary ? StationaryFrames + 1 : 0;
+	if (StationaryFrames >= DormancyFrames)
+	{
+		bDormant = true;
+		FixedTimeAccumulator = 0.f;
+		ScheduledTimeAccumulator = 0.f;
+
+		if (FMultiCollisionScheduler::IsEnabled())
+		{
+			// dormant mover doesn't ask for updates, its slot goes to the movers which do
+			FMultiCollisionScheduler::Get(GetWorld()).Remove(this);
+		}
+	}
+}
+
+void UMultiCollisionMovementComponent::AdditionalComponentBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
+{
+	WakeUp();
+}
+
+void UMultiCollisionMovementComponent::StartNewPhysics(float deltaTime, int32 Iterations)
+{
+	if (ScheduledSubstepTime <= 0.f || bInPhysicsSubstep)
+	{
+		Super::StartNewPhysics(deltaTime, Iterations);
+		return;
+	}
+
+	// split the large scheduled move to safe steps with the same acceleration, physics mode changes inside the step are simulated with the rest of the step time
+	TGuardValue<bool> PhysicsSubstepGuard(bInPhysicsSubstep, true);
+
+	float RemainingTime = deltaTime;
+	while (RemainingTime >= MIN_TICK_TIME && HasValidData())
+	{
+		const float StepTime = FMath::Min(ScheduledSubstepTime, RemainingTime);
+		Super::StartNewPhysics(StepTime, Iterations);
+		RemainingTime -= StepTime;
+	}
+}
+
 void UMultiCollisionMovementComponent::UpdateAdditionalUpdatedComponents()
 {
 	class AMultiCollisionCharacter* MultiCollisionOwner = Cast<AMultiCollisionCharacter>(GetCharacterOwner());
@@ -24,32 +357,46 @@ void UMultiCollisionMovementComponent::UpdateAdditionalUpdatedComponents()
 		return;
 	}
 
+	// statistics of the old components list are kept before it is collected again
+	FMultiCollisionAnalytics::RetireStats(this);
+
 	// 1. Remove old if exist (for runtime character reconfiguration/changes)
 	for (int32 i = 0; i < AdditionalUpdatedComponents.Num(); i++)
 	{
-		if (auto AdditionalComponent = Cast<UMultiCollisionCapsuleComponent>(AdditionalUpdatedComponents[i]))
+		if (auto AdditionalComponent = AdditionalUpdatedComponents[i])
 		{
 			AdditionalComponent->MoveIgnoreActors.Empty();
 
-			if (bEnablePhysicsInteraction)
-			{
-				AdditionalComponent->OnComponentBeginOverlap.RemoveAll(this);
-			}
+			// removes CapsuleTouched and dormancy wake up bindings
+			AdditionalComponent->OnComponentBeginOverlap.RemoveAll(this);
+			AdditionalComponent->OnComponentCollisionSettingsChangedEvent.RemoveAll(this);
 		}
 	}
 
 	AdditionalUpdatedComponents.Empty();
+	StaticGeometryCache.Reset();
+	MoveRecorder.Reset(); // recorded stream has the old components list, next move opens a new stream
 
 	// SHOULD WE REUPDATE IGNORE ACTORS?
 	//UpdatedPrimitive->MoveIgnoreActors = get ignore actors from character owner
 
 	// 2. Collect all additional collisions
 
-	auto CollisionComponents = MultiCollisionOwner->GetComponentsByClass(UMultiCollisionCapsuleComponent::StaticClass());
+	// capsule, box and sphere multi-collision components are collected by the shared interface
+	auto CollisionComponents = MultiCollisionOwner->GetComponentsByInterface(UMultiCollisionComponent::StaticClass());
 	for (int32 i = 0; i < CollisionComponents.Num(); i++)
 	{
-		if (auto AdditionalComponent = Cast<UMultiCollisionCapsuleComponent>(CollisionComponents[i]))
+		if (auto AdditionalComponent = Cast<UPrimitiveComponent>(CollisionComponents[i]))
 		{
+			if (bUseMoverGrid)
+			{
+				// other grid movers find this one only in the grid, not in the world query
+				AdditionalComponent->SetCollisionObjectType(MoverGridObjectType);
+			}
+
+			// query filter of the component is built again when its collision settings are changed
+			AdditionalComponent->OnComponentCollisionSettingsChangedEvent.AddUObject(this, &UMultiCollisionMovementComponent::AdditionalComponentCollisionSettingsChanged);
+
 			AdditionalComponent->MoveIgnoreActors.Add(MultiCollisionOwner);
 			AdditionalComponent->MoveIgnoreActors += UpdatedPrimitive->MoveIgnoreActors;
 
@@ -58,12 +405,214 @@ void UMultiCollisionMovementComponent::UpdateAdditionalUpdatedComponents()
 				AdditionalComponent->OnComponentBeginOverlap.AddUniqueDynamic(this, &UMultiCollisionMovementComponent::CapsuleTouched);
 			}
 
+			if (bEnableDormancy)
+			{
+				AdditionalComponent->OnComponentBeginOverlap.AddUniqueDynamic(this, &UMultiCollisionMovementComponent::AdditionalComponentBeginOverlap);
+			}
+
 			AdditionalUpdatedComponents.Add(AdditionalComponent);
 		}
 	}
+
+	if (bUseMoverGrid && UpdatedPrimitive)
+	{
+		UpdatedPrimitive->SetCollisionObjectType(MoverGridObjectType);
+	}
+
+	RootMoveIgnoreActors = UpdatedPrimitive ? UpdatedPrimitive->MoveIgnoreActors : TArray<AActor*>();
+
+	// components order decides which one wins on equal hit time, so it should not depend on the order of components creation
+	AdditionalUpdatedComponents.Sort([](const UPrimitiveComponent& A, const UPrimitiveComponent& B) { return A.GetFName().Compare(B.GetFName()) < 0; });
+
+	ResetAdditionalComponentStats();
+	UpdateQueryFilters();
+}
+
+void UMultiCollisionMovementComponent::UpdateQueryFilters()
+{
+	QueryFilters.Reset();
+	QueryGroups.Reset();
+
+	for (int32 i = 0; i < AdditionalUpdatedComponents.Num(); i++)
+	{
+		FMultiCollisionQueryFilter& Filter = QueryFilters[QueryFilters.AddDefaulted()];
+		if (!AdditionalUpdatedComponents[i])
+		{
+			continue;
+		}
+
+		IMultiCollisionComponent::InitQueryFilter(AdditionalUpdatedComponents[i], Filter, bUseMoverGrid ? (ECollisionChannel)MoverGridObjectType : ECC_MAX);
+
+		// find the group with the same object type and responses
+		for (int32 GroupIndex = 0; GroupIndex < QueryGroups.Num(); GroupIndex++)
+		{
+			const FQueryGroup& Group = QueryGroups[GroupIndex];
+			if (Group.ObjectType == Filter.ObjectType && Group.bCanBlock == Filter.bCanBlock
+				&& FMemory::Memcmp(Group.ResponseParams.CollisionResponse.EnumArray, Filter.ResponseParams.CollisionResponse.EnumArray, sizeof(Group.ResponseParams.CollisionResponse.EnumArray)) == 0)
+			{
+				Filter.GroupIndex = GroupIndex;
+				break;
+			}
+		}
+
+		if (Filter.GroupIndex == INDEX_NONE)
+		{
+			FQueryGroup NewGroup;
+			NewGroup.ObjectType = Filter.ObjectType;
+			NewGroup.ResponseParams = Filter.ResponseParams;
+			NewGroup.bCanBlock = Filter.bCanBlock;
+			NewGroup.NumComponents = 0;
+			NewGroup.bSkip = false;
+			NewGroup.bBlocked = false;
+			Filter.GroupIndex = QueryGroups.Add(NewGroup);
+		}
+
+		QueryGroups[Filter.GroupIndex].NumComponents++;
+	}
+}
+
+void UMultiCollisionMovementComponent::AdditionalComponentCollisionSettingsChanged(UPrimitiveComponent* ChangedComponent)
+{
+	// groups depend on object type and responses, so all filters are built again
+	UpdateQueryFilters();
+}
+
+void UMultiCollisionMovementComponent::UpdateMoveIgnoreActors()
+{
+	// IgnoreActorWhenMoving() has no event, so ignored actors of the updated component are compared on every move
+	if (!UpdatedPrimitive || UpdatedPrimitive->MoveIgnoreActors == RootMoveIgnoreActors)
+	{
+		return;
+	}
+
+	AActor* Owner = GetOwner();
+	for (int32 i = 0; i < AdditionalUpdatedComponents.Num(); i++)
+	{
+		UPrimitiveComponent* AdditionalComponent = AdditionalUpdatedComponents[i];
+		if (!AdditionalComponent)
+		{
+			continue;
+		}
+
+		for (int32 ActorIndex = 0; ActorIndex < RootMoveIgnoreActors.Num(); ActorIndex++)
+		{
+			AActor* OldActor = RootMoveIgnoreActors[ActorIndex];
+			if (OldActor != Owner && !UpdatedPrimitive->MoveIgnoreActors.Contains(OldActor))
+			{
+				AdditionalComponent->MoveIgnoreActors.Remove(OldActor);
+			}
+		}
+
+		for (int32 ActorIndex = 0; ActorIndex < UpdatedPrimitive->MoveIgnoreActors.Num(); ActorIndex++)
+		{
+			AdditionalComponent->MoveIgnoreActors.AddUnique(UpdatedPrimitive->MoveIgnoreActors[ActorIndex]);
+		}
+	}
+
+	RootMoveIgnoreActors = UpdatedPrimitive->MoveIgnoreActors;
+}
+
+void UMultiCollisionMovementComponent::PreTestQueryGroups(const FBox& MoveBox)
+{
+	FCollisionQueryParams PreTestParams(TEXT("MultiCollisionGroupPreTest"), false, GetOwner());
+
+	for (int32 GroupIndex = 0; GroupIndex < QueryGroups.Num(); GroupIndex++)
+	{
+		FQueryGroup& Group = QueryGroups[GroupIndex];
+		Group.bSkip = !Group.bCanBlock;
+
+		// one overlap is cheaper than several sweeps only for groups with several components, and only in open space: near blocking geometry the overlap never skips the group
+		if (!Group.bSkip && bUseQueryGroupPreTest && Group.NumComponents > 1 && !Group.bBlocked && MoveBox.IsValid)
+		{
+			Group.bSkip = !GetWorld()->OverlapBlockingTestByChannel(MoveBox.GetCenter(), FQuat::Identity, Group.ObjectType, FCollisionShape::MakeBox(MoveBox.GetExtent()), PreTestParams, Group.ResponseParams);
+		}
+
+		Group.bBlocked = false;
+	}
+}
+
+void UMultiCollisionMovementComponent::GetAdditionalUpdatedComponentNames(TArray<FString>& OutNames) const
+{
+	OutNames.Reset();
+	for (int32 i = 0; i < AdditionalUpdatedComponents.Num(); i++)
+	{
+		OutNames.Add(GetNameSafe(AdditionalUpdatedComponents[i]));
+	}
+}
+
+void UMultiCollisionMovementComponent::ResetAdditionalComponentStats()
+{
+	AdditionalComponentStats.Reset();
+	AdditionalComponentStats.SetNum(AdditionalUpdatedComponents.Num());
+}
+
+bool UMultiCollisionMovementComponent::UpdateMoveRecorder()
+{
+	if (RecordMovesCVar == 0)
+	{
+		MoveRecorder.Reset(); // closes the stream
+		return false;
+	}
+
+	if (!MoveRecorder.IsValid())
+	{
+		FMultiCollisionMoveStreamHeader Header;
+		Header.MapName = UWorld::RemovePIEPrefix(GetWorld()->GetOutermost()->GetName());
+		for (int32 i = 0; i < GetWorld()->StreamingLevels.Num(); i++)
+		{
+			const ULevelStreaming* StreamingLevel = GetWorld()->StreamingLevels[i];
+			if (StreamingLevel && StreamingLevel->GetLoadedLevel() && StreamingLevel->GetLoadedLevel()->bIsVisible)
+			{
+				Header.StreamingLevels.Add(UWorld::RemovePIEPrefix(StreamingLevel->GetWorldAssetPackageName()));
+			}
+		}
+		Header.CharacterClass = GetOwner()->GetClass()->GetPathName();
+		GetAdditionalUpdatedComponentNames(Header.ComponentNames);
+
+		// the stream is reopened when additional components change, so time with milliseconds and stream index keep the previous stream
+		const FString Filename = FPaths::ProjectSavedDir() / TEXT("MultiCollision") / FString::Printf(TEXT("%s_%s_%d.mcmove"), *GetNameSafe(GetOwner()), *FDateTime::Now().ToString(TEXT("%Y.%m.%d-%H.%M.%S.%s")), NumMoveStreams++);
+
+		MoveRecorder = MakeUnique<FMultiCollisionMoveRecorder>();
+		MoveRecorder->Open(Filename, Header);
+	}
+
+	return MoveRecorder->IsOpen();
 }
 
 bool UMultiCollisionMovementComponent::MoveUpdatedComponentImpl(const FVector& Delta, const FQuat& Rotation, bool bSweep, FHitResult* OutHit, ETeleportType Teleport)
+{
+	if (!UpdatedComponent || !UpdateMoveRecorder())
+	{
+		return MoveUpdatedAndAdditionalComponents(Delta, Rotation, bSweep, OutHit);
+	}
+
+	FMultiCollisionMoveRecord Record;
+	Record.Frame = (uint32)GFrameCounter;
+	Record.StartLocation = UpdatedComponent->GetComponentLocation();
+	Record.StartRotation = UpdatedComponent->GetComponentQuat();
+	Record.Delta = Delta;
+	Record.Rotation = Rotation;
+	Record.bSweep = bSweep;
+	Record.MoveFlags = (uint8)MoveComponentFlags;
+
+	Record.bMoved = MoveUpdatedAndAdditionalComponents(Delta, Rotation, bSweep, OutHit);
+
+	Record.EndLocation = UpdatedComponent->GetComponentLocation();
+	if (OutHit)
+	{
+		Record.HitTime = OutHit->Time;
+		Record.HitNormal = OutHit->Normal;
+		Record.HitImpactPoint = OutHit->ImpactPoint;
+		Record.bStartPenetrating = OutHit->bStartPenetrating;
+	}
+	Record.BlockedComponentIndex = Record.bMoved ? INDEX_NONE : AdditionalUpdatedComponents.IndexOfByKey(LastBlockedComponent);
+
+	MoveRecorder->Record(Record);
+
+	return Record.bMoved;
+}
+
+bool UMultiCollisionMovementComponent::MoveUpdatedAndAdditionalComponents(const FVector& Delta, const FQuat& Rotation, bool bSweep, FHitResult* OutHit)
 {
 	if (!UpdatedComponent)
 	{
@@ -99,6 +648,12 @@ bool UMultiCollisionMovementComponent::MoveUpdatedComponentImpl(const FVector& D
 
 	if (!bMoved)
 	{
+		if (bDeterministicSimulation)
+		{
+			// snap hit time down to the power of two grid, so tiny differences of sweep results don't go to the slerp and to the next moves
+			OutHit->Time = FMath::FloorToFloat(OutHit->Time * 1024.f) / 1024.f;
+		}
+
 		NewDelta *= OutHit->Time; // adjust delta to move as much as possible to location before the hit based on hit time
 		NewRotation = FQuat::Slerp(UpdatedComponent->GetComponentQuat(), Rotation, OutHit->Time); // adjust rotation
 	}
@@ -114,34 +669,82 @@ bool UMultiCollisionMovementComponent::MoveUpdatedComponentImpl(const FVector& D
 
 bool UMultiCollisionMovementComponent::MoveAdditionalUpdatedComponents(const FVector& Delta, const FQuat& NewRotation, FHitResult* OutHit)
 {
-	// init array of blocking hits
-	TArray<FHitResult> BlockedHits;
-	BlockedHits.Empty();
-
-	// init array of blocked components related to blocked hits
-	TArray<UMultiCollisionCapsuleComponent*> BlockedComponents;
-	BlockedComponents.Empty();
+	// init array of blocking contacts, full hits stay in the per component hits buffers
+	BlockedContacts.Reset();
+	SweepHitBuffers.SetNum(AdditionalUpdatedComponents.Num());
 
 	// init current movement blocked component
 	LastBlockedComponent = nullptr;
 
+	UpdateMoveIgnoreActors();
+
+	// static geometry and other movers around the character for all additional components sweeps
+	SweepContext.Reset();
+	if (bUseStaticGeometryCache || bUseMoverGrid || QueryGroups.Num() > 0)
+	{
+		const FBox MoveBox = GetMoveBounds(Delta);
+
+		PreTestQueryGroups(MoveBox);
+
+		if (bUseStaticGeometryCache)
+		{
+			SweepContext.StaticCache = UpdateStaticGeometryCache(MoveBox);
+		}
+
+		if (bUseMoverGrid)
+		{
+			CollectNearbyMovers(MoveBox);
+		}
+	}
+
+	const bool bCollectStats = FMultiCollisionAnalytics::IsEnabled() && AdditionalComponentStats.Num() == AdditionalUpdatedComponents.Num();
+
 	// we are checking if any of the additional components goes in block of another object and saving the results of every component test
 	for (int32 i = 0; i < AdditionalUpdatedComponents.Num(); i++)
 	{
 		if (AdditionalUpdatedComponents[i])
 		{
-			FHitResult BlockedHit = FHitResult(1.f);
-			const bool bMoveResult = AdditionalUpdatedComponents[i]->SimulateMoveComponent(UpdatedComponent, Delta, NewRotation, &BlockedHit, MoveComponentFlags);
+			// precomputed query params and group pre-test, filters are rebuilt with the components list
+			const FMultiCollisionQueryFilter* QueryFilter = QueryFilters.IsValidIndex(i) ? &QueryFilters[i] : nullptr;
+			if (QueryFilter && QueryGroups.IsValidIndex(QueryFilter->GroupIndex) && QueryGroups[QueryFilter->GroupIndex].bSkip)
+			{
+				continue; // nothing can block this component in the move
+			}
+
+			if (QueryFilter && QueryFilter->MoveIgnoreActors != AdditionalUpdatedComponents[i]->MoveIgnoreActors)
+			{
+				// ignored actors changed at runtime, object type and responses are the same, so the group stays
+				IMultiCollisionComponent::InitQueryFilter(AdditionalUpdatedComponents[i], QueryFilters[i], bUseMoverGrid ? (ECollisionChannel)MoverGridObjectType : ECC_MAX);
+			}
+
+			const uint32 StartCycles = bCollectStats ? FPlatformTime::Cycles() : 0;
+
+			FMultiCollisionContact BlockedContact;
+			const bool bMoveResult = IMultiCollisionComponent::SimulateMoveComponent(AdditionalUpdatedComponents[i], UpdatedComponent, Delta, NewRotation, SweepHitBuffers[i], BlockedContact, MoveComponentFlags, &SweepContext, QueryFilter);
 
 			if (!bMoveResult)
 			{
-				BlockedHits.Add(BlockedHit);
-				BlockedComponents.Add(AdditionalUpdatedComponents[i]);
+				BlockedContact.ComponentIndex = i;
+				BlockedContacts.Add(BlockedContact);
+
+				if (QueryFilter && QueryGroups.IsValidIndex(QueryFilter->GroupIndex))
+				{
+					QueryGroups[QueryFilter->GroupIndex].bBlocked = true;
+				}
+			}
+
+			if (bCollectStats)
+			{
+				FMultiCollisionComponentStats& Stats = AdditionalComponentStats[i];
+				Stats.Cycles += FPlatformTime::Cycles() - StartCycles;
+				Stats.Sweeps++;
+				Stats.BlockingHits += bMoveResult ? 0 : 1;
+				Stats.Penetrations += (!bMoveResult && BlockedContact.bStartPenetrating) ? 1 : 0;
 			}
 		}
 	}
 
-	if (BlockedHits.Num() > 0)
+	if (BlockedContacts.Num() > 0)
 	{
 		// there is situation when we move forward and ship wings can be larger in front of the trunk. but the move delta can very high especially when boosting or dodging
 		// large move delta can cause that several components will penetrate another object. we need to find the one which is the most far penetrated the object.
@@ -151,9 +754,9 @@ bool UMultiCollisionMovementComponent::MoveAdditionalUpdatedComponents(const FVe
 		int32 BadIndex = 0;
 		float BadTime = 1.f;
 
-		for (int32 i = 0; i < BlockedHits.Num(); i++)
+		for (int32 i = 0; i < BlockedContacts.Num(); i++)
 		{
-			const float TestTime = BlockedHits[i].Time;
+			const float TestTime = BlockedContacts[i].Time;
 			if (TestTime < BadTime)
 			{
 				BadTime = TestTime;
@@ -161,8 +764,25 @@ bool UMultiCollisionMovementComponent::MoveAdditionalUpdatedComponents(const FVe
 			}
 		}
 
-		*OutHit = BlockedHits[BadIndex]; // save the most bad hit result
-		LastBlockedComponent = BlockedComponents[BadIndex]; // save component which caused the most bad hit
+		const FMultiCollisionContact& BadContact = BlockedContacts[BadIndex];
+		BadContact.ExpandHitResult(SweepHitBuffers[BadContact.ComponentIndex], *OutHit); // save the most bad hit result, the only full hit copy of the move
+		LastBlockedComponent = AdditionalUpdatedComponents[BadContact.ComponentIndex]; // save component which caused the most bad hit
+
+		if (bCollectStats)
+		{
+			// winner and components which were blocked later than the winner
+			AdditionalComponentStats[BadContact.ComponentIndex].Wins++;
+			for (int32 i = 0; i < BlockedContacts.Num(); i++)
+			{
+				if (i != BadIndex)
+				{
+					FMultiCollisionComponentStats& Stats = AdditionalComponentStats[BlockedContacts[i].ComponentIndex];
+					Stats.Shadowed++;
+					Stats.ShadowedBy.SetNumZeroed(AdditionalUpdatedComponents.Num());
+					Stats.ShadowedBy[BadContact.ComponentIndex]++;
+				}
+			}
+		}
 
 		return false; // our move was blocked. the performed move failed and requires a correction.
 	}
@@ -173,6 +793,51 @@ bool UMultiCollisionMovementComponent::MoveAdditionalUpdatedComponents(const FVe
 	}
 }
 
+FBox UMultiCollisionMovementComponent::GetMoveBounds(const FVector& Delta) const
+{
+	// find the radius around the root which covers all additional components at any rotation
+	const FVector RootLocation = UpdatedComponent->GetComponentLocation();
+	float BoundsRadius = 0.f;
+	for (int32 i = 0; i < AdditionalUpdatedComponents.Num(); i++)
+	{
+		if (AdditionalUpdatedComponents[i])
+		{
+			const FBoxSphereBounds& ComponentBounds = AdditionalUpdatedComponents[i]->Bounds;
+			BoundsRadius = FMath::Max(BoundsRadius, FVector::Dist(ComponentBounds.Origin, RootLocation) + ComponentBounds.SphereRadius);
+		}
+	}
+
+	// region of the whole move including turn
+	FBox MoveBox(ForceInit);
+	MoveBox += FBox::BuildAABB(RootLocation, FVector(BoundsRadius));
+	MoveBox += FBox::BuildAABB(RootLocation + Delta, FVector(BoundsRadius));
+	return MoveBox;
+}
+
+const FMultiCollisionStaticCache* UMultiCollisionMovementComponent::UpdateStaticGeometryCache(const FBox& MoveBox)
+{
+	if (!StaticGeometryCache.Contains(MoveBox))
+	{
+		FCollisionQueryParams CacheQueryParams(TEXT("MultiCollisionStaticCache"), false, GetOwner());
+		StaticGeometryCache.Refresh(GetWorld(), MoveBox, StaticGeometryCacheMargin, CacheQueryParams);
+	}
+
+	return &StaticGeometryCache;
+}
+
+void UMultiCollisionMovementComponent::CollectNearbyMovers(const FBox& MoveBox)
+{
+	NearbyMovers.Reset();
+	FMultiCollisionMoverGrid::Get(GetWorld()).Query(MoveBox, this, NearbyMovers);
+
+	for (int32 i = 0; i < NearbyMovers.Num(); i++)
+	{
+		// additional components and root of other mover have the mover grid object type, so they are tested only by direct sweeps. Its other collision components (e.g. mesh) are tested by the world query.
+		SweepContext.NearbyMoverComponents.Append(NearbyMovers[i]->GetAdditionalUpdatedComponents());
+		SweepContext.NearbyMoverComponents.Add(NearbyMovers[i]->UpdatedPrimitive);
+	}
+}
+
 bool UMultiCollisionMovementComponent::ResolvePenetrationImpl(const FVector& ProposedAdjustment, const FHitResult& Hit, const FQuat& Rotation)
 {
 	if (!LastBlockedComponent)
@@ -245,6 +910,21 @@ bool UMultiCollisionMovementComponent::ResolvePenetrationImpl(const FVector& Pro
 
 void UMultiCollisionMovementComponent::PhysicsRotation(float DeltaTime)
 {
+	if (ScheduledSubstepTime > 0.f && !bInPhysicsSubstep && DeltaTime > ScheduledSubstepTime)
+	{
+		// large accumulated time of scheduled mover turns with the same safe steps as the move, so every rotation sweep is short
+		TGuardValue<bool> PhysicsSubstepGuard(bInPhysicsSubstep, true);
+
+		float RemainingTime = DeltaTime;
+		while (RemainingTime >= MIN_TICK_TIME && HasValidData())
+		{
+			const float StepTime = FMath::Min(ScheduledSubstepTime, RemainingTime);
+			PhysicsRotation(StepTime);
+			RemainingTime -= StepTime;
+		}
+		return;
+	}
+
 	if (!(bOrientRotationToMovement || bUseControllerDesiredRotation))
 	{
 		return;
@@ -275,16 +955,7 @@ void UMultiCollisionMovementComponent::PhysicsRotation(float DeltaTime)
 		return;
 	}
 
-	if (ShouldRemainVertical())
-	{
-		DesiredRotation.Pitch = 0.f;
-		DesiredRotation.Yaw = FRotator::NormalizeAxis(DesiredRotation.Yaw);
-		DesiredRotation.Roll = 0.f;
-	}
-	else
-	{
-		DesiredRotation.Normalize();
-	}
+	NormalizeDesiredRotation(DesiredRotation);
 
 	// Accumulate a desired new rotation.
 	const float AngleTolerance = 1e-3f;
@@ -1,5 +1,9 @@
 #pragma once
 #include "Runtime/Engine/Classes/GameFramework/CharacterMovementComponent.h"
+#include "MultiCollisionStaticCache.h"
+#include "MultiCollisionMoveRecorder.h"
+#include "MultiCollisionComponent.h"
+#include "MultiCollisionAnalytics.h"
 #include "MultiCollisionMovementComponent.generated.h"
 
 UCLASS()
@@ -12,16 +16,67 @@ public:
 	
 	virtual void InitializeComponent() override;
 
+	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction) override;
+
+	virtual void StartNewPhysics(float deltaTime, int32 Iterations) override;
+
+	virtual FVector ConsumeInputVector() override;
+
 	void UpdateAdditionalUpdatedComponents();
 
 	virtual void PhysicsRotation(float DeltaTime) override;
 
+	virtual void OnTeleported() override;
+
 	void SetPendingRotation(const FQuat NewPendingRotation);
+
+	/** Component which blocked the last move, null if the move was not blocked */
+	class UPrimitiveComponent* GetLastBlockedComponent() const { return LastBlockedComponent; }
+
+	/** Names of additional updated components in the order used by the move stream */
+	void GetAdditionalUpdatedComponentNames(TArray<FString>& OutNames) const;
+
+	/** Additional collision components swept on movement */
+	const TArray<class UPrimitiveComponent*>& GetAdditionalUpdatedComponents() const { return AdditionalUpdatedComponents; }
+
+	/** Bounds of all collision components of the character, invalid box if nothing has collision */
+	FBox GetMoverBounds() const;
+
+	/** Statistics of additional components collected with mc.Analytics, indices match additional updated components */
+	const TArray<FMultiCollisionComponentStats>& GetAdditionalComponentStats() const { return AdditionalComponentStats; }
+
+	/** Zero statistics of additional components */
+	void ResetAdditionalComponentStats();
+
+	/** Analytics rows (character class and component name) which already count this mover as an instance */
+	const TSet<FString>& GetCountedStatsRows() const { return CountedStatsRows; }
+	TSet<FString>& GetCountedStatsRows() { return CountedStatsRows; }
+
+	/** Rebuild precomputed sweep query params of additional components. Collision settings and ignored actors changes are picked up by the movement component, call it after other changes of the query params. */
+	UFUNCTION(BlueprintCallable, Category = "Pawn|Components|CharacterMovement")
+	void UpdateQueryFilters();
+
+	/** Significant mover is updated every frame regardless of the frame budget */
+	void SetAlwaysUpdateMovement(bool bNewAlwaysUpdateMovement) { bAlwaysUpdateMovement = bNewAlwaysUpdateMovement; }
+
+	/** Wake up dormant character, next tick simulates movement again */
+	UFUNCTION(BlueprintCallable, Category = "Pawn|Components|CharacterMovement")
+	void WakeUp();
+
+	/** True if stationary character stopped ticking its movement */
+	UFUNCTION(BlueprintCallable, Category = "Pawn|Components|CharacterMovement")
+	bool IsDormant() const { return bDormant; }
 	
 protected:
 
 	virtual void OnMovementUpdated(float DeltaSeconds, const FVector & OldLocation, const FVector & OldVelocity) override;
 
+	virtual void OnMovementModeChanged(EMovementMode PreviousMovementMode, uint8 PreviousCustomMode) override;
+
 	//virtual void PhysFlying(float deltaTime, int32 Iterations) override;
 	//virtual void PhysWalking(float deltaTime, int32 Iterations) override;
 
@@ -29,20 +84,188 @@ protected:
 
 	virtual bool ResolvePenetrationImpl(const FVector& Adjustment, const FHitResult& Hit, const FQuat& Rotation) override;
 
+	/** Object type, responses or query collision of additional component changed */
+	void AdditionalComponentCollisionSettingsChanged(UPrimitiveComponent* ChangedComponent);
+
+	UFUNCTION()
+	void AdditionalComponentBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
+
 	//  this is a movement component CVarPenetrationOverlapCheckInflation copy
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Movement")
 	/** Inflation added to object when checking if a location is free of blocking collision. Distance added to inflation in penetration overlap check. */
 	float PenetrationOverlapCheckInflation;
 
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Movement")
+	/** If enabled, static world geometry around the character is cached and additional components sweep against the cache instead of the world query. */
+	bool bUseStaticGeometryCache;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Movement", meta = (EditCondition = "bUseStaticGeometryCache", ClampMin = "0", UIMin = "0"))
+	/** Distance added around the character bounds when static geometry cache is collected. Larger margin means less cache refreshes but more cached primitives. */
+	float StaticGeometryCacheMargin;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Movement")
+	/** If enabled, the character is registered in the grid of multi-collision movers. Blocking by other registered movers is resolved by direct sweeps against their collision components instead of the world query. */
+	bool bUseMoverGrid;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Movement", meta = (EditCondition = "bUseMoverGrid"))
+	/** Object type of additional components and root of movers registered in the grid. It should be a dedicated object channel (MultiCollisionMover in DefaultEngine.ini), the world query of grid movers ignores it. */
+	TEnumAsByte<ECollisionChannel> MoverGridObjectType;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Movement")
+	/** If enabled, movement is simulated with fixed time steps and hit times are quantized, so the same input gives the same trajectory. Used for lockstep/rollback and replays. */
+	bool bDeterministicSimulation;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Movement", meta = (EditCondition = "bDeterministicSimulation", ClampMin = "0.001", UIMin = "0.001"))
+	/** Time of one simulation step in deterministic simulation */
+	float FixedTimeStep;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Movement", meta = (EditCondition = "bDeterministicSimulation", ClampMin = "1", UIMin = "1"))
+	/** Max number of fixed steps simulated in one tick. Time above this limit is dropped to avoid spiral of death on long frames. */
+	int32 MaxFixedTimeSteps;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Movement")
+	/** If enabled, additional components with the same collision responses are tested by one overlap of the whole move region before their sweeps when the previous move of the group was not blocked. If nothing blocking is there, sweeps of the whole group are skipped. Helps characters which move mostly in open space. */
+	bool bUseQueryGroupPreTest;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
+	/** Significant mover is updated every frame like player controlled one, other AI movers are updated round robin inside the frame budget (mc.Scheduler.BudgetMs). */
+	bool bAlwaysUpdateMovement;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Movement")
+	/** If enabled, character which doesn't move and turn for DormancyFrames stops ticking movement until input, impulse, moving base, overlap, teleport, movement mode, floor or gravity change wakes it up. */
+	bool bEnableDormancy;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Movement", meta = (EditCondition = "bEnableDormancy", ClampMin = "1", UIMin = "1"))
+	/** Number of stationary frames before the character becomes dormant */
+	int32 DormancyFrames;
+
 
 private:
 
 	UPROPERTY()
-	TArray<class UMultiCollisionCapsuleComponent*> AdditionalUpdatedComponents;
+	TArray<class UPrimitiveComponent*> AdditionalUpdatedComponents;
 
 	UPROPERTY()
 	class UPrimitiveComponent* LastBlockedComponent;
 
+	/** Move updated component with sweeps of additional components, MoveUpdatedComponentImpl() is a recording wrapper around it */
+	bool MoveUpdatedAndAdditionalComponents(const FVector& Delta, const FQuat& Rotation, bool bSweep, FHitResult* OutHit);
+
+	/** Writer of the move stream when mc.RecordMoves is enabled */
+	TUniquePtr<FMultiCollisionMoveRecorder> MoveRecorder;
+
+	/** Number of move streams opened by the character, keeps file names unique when the stream is reopened */
+	int32 NumMoveStreams;
+
+	/** Open or close the move stream following mc.RecordMoves, returns true if moves should be recorded */
+	bool UpdateMoveRecorder();
+
 	bool MoveAdditionalUpdatedComponents(const FVector& Delta, const FQuat& NewRotation, FHitResult* OutHit);
 
+	/** Frame time which is not simulated yet in deterministic simulation */
+	float FixedTimeAccumulator;
+
+	/** Input of the frame, used by every fixed step of the tick */
+	FVector FixedStepInputVector;
+
+	/** True while the tick is simulated with fixed steps */
+	bool bInFixedStepTick;
+
+	/** Deterministic simulation steps only the side which simulates the character locally, proxies follow the engine tick */
+	bool ShouldUseFixedTimeSteps() const;
+
+	/** True while the large scheduled move or turn is split to steps */
+	bool bInPhysicsSubstep;
+
+	/** Frame time waiting for the turn of scheduled mover */
+	float ScheduledTimeAccumulator;
+
+	/** Step time of the large move of scheduled mover, 0 if the move is not split */
+	float ScheduledSubstepTime;
+
+	/** True if the mover waits for its turn inside the frame budget (mc.Scheduler.BudgetMs) */
+	bool ShouldScheduleMovement() const;
+
+	/** True while stationary character doesn't tick movement */
+	bool bDormant;
+
+	/** Number of stationary frames in a row */
+	int32 StationaryFrames;
+
+	/** Updated component transform on previous tick to find stationary frames and external moves of dormant character */
+	FQuat LastTickRotation;
+	FVector LastTickLocation;
+
+	/** Gravity and physics volume on previous tick, dormant character wakes up when they change */
+	float LastTickGravityZ;
+	TWeakObjectPtr<class APhysicsVolume> LastTickPhysicsVolume;
+
+	/** Something asks for movement: input, requested velocity, impulse, root motion, rotation, not static base, lost floor, teleport or gravity change */
+	bool ShouldWakeUp() const;
+
+	/** Desired rotation with the same remain vertical normalization PhysicsRotation() applies */
+	void NormalizeDesiredRotation(FRotator& DesiredRotation) const;
+
+	/** Count stationary frames after the tick and make the character dormant */
+	void UpdateDormancy();
+
+	/** Cache of static geometry around the character */
+	FMultiCollisionStaticCache StaticGeometryCache;
+
+	/** Refresh static geometry cache if the move leaves the cached region */
+	const FMultiCollisionStaticCache* UpdateStaticGeometryCache(const FBox& MoveBox);
+
+	/** Region of the whole move including turn */
+	FBox GetMoveBounds(const FVector& Delta) const;
+
+	/** Find other movers in the grid near the move and add their collision components to the sweep context */
+	void CollectNearbyMovers(const FBox& MoveBox);
+
+	/** World data for sweeps of the current move */
+	FMultiCollisionSweepContext SweepContext;
+
+	/** Hits of the last sweep of every additional component, indices match AdditionalUpdatedComponents. Buffers keep allocations between moves. */
+	TArray<TArray<FHitResult>> SweepHitBuffers;
+
+	/** Additional components with the same object type and collision responses */
+	struct FQueryGroup
+	{
+		ECollisionChannel ObjectType;
+		FCollisionResponseParams ResponseParams;
+		bool bCanBlock;
+		int32 NumComponents;
+
+		/** Sweeps of the group are skipped in the current move */
+		bool bSkip;
+
+		/** A component of the group was blocked in the last move, so the pre-test would not skip the group */
+		bool bBlocked;
+	};
+
+	/** Precomputed sweep query params, indices match AdditionalUpdatedComponents */
+	TArray<FMultiCollisionQueryFilter> QueryFilters;
+
+	TArray<FQueryGroup> QueryGroups;
+
+	/** Decide which groups can be skipped in the move */
+	void PreTestQueryGroups(const FBox& MoveBox);
+
+	/** Pass ignored actors changes of the updated component to additional components */
+	void UpdateMoveIgnoreActors();
+
+	/** Ignored actors of the updated component which were passed to additional components */
+	TArray<AActor*> RootMoveIgnoreActors;
+
+	/** Statistics of additional components, indices match AdditionalUpdatedComponents */
+	TArray<FMultiCollisionComponentStats> AdditionalComponentStats;
+
+	/** Retired analytics rows of this mover, they keep counting it after its statistics are reset by recollection */
+	TSet<FString> CountedStatsRows;
+
+	/** Blocking contacts of additional components in the current move */
+	TArray<FMultiCollisionContact> BlockedContacts;
+
+	/** Movers found in the grid for the current move */
+	TArray<UMultiCollisionMovementComponent*> NearbyMovers;
+
 };
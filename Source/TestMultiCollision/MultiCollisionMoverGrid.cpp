@@ -0,0 +1,142 @@
+#include "MultiCollisionMoverGrid.h"
+#include "MultiCollisionMovementComponent.h"
+#include "Runtime/Engine/Classes/Engine/World.h"
+
+static float MoverGridCellSizeCVar = 2000.f;
+static FAutoConsoleVariableRef CVarMoverGridCellSize(
+	TEXT("mc.MoverGrid.CellSize"),
+	MoverGridCellSizeCVar,
+	TEXT("Cell size of the grid of multi-collision movers.\n")
+	TEXT("Should be about the size of the largest mover."),
+	ECVF_Default);
+
+/** Grids of all worlds with registered movers */
+static TMap<const UWorld*, FMultiCollisionMoverGrid> MoverGrids;
+
+FMultiCollisionMoverGrid::FMultiCollisionMoverGrid() : CellSize(MoverGridCellSizeCVar), UpdateFrame(0)
+{
+
+}
+
+FMultiCollisionMoverGrid& FMultiCollisionMoverGrid::Get(const UWorld* World)
+{
+	return MoverGrids.FindOrAdd(World);
+}
+
+void FMultiCollisionMoverGrid::Register(UMultiCollisionMovementComponent* Mover)
+{
+	Movers.AddUnique(Mover);
+	UpdateFrame = 0; // rebuild on next query
+}
+
+void FMultiCollisionMoverGrid::Unregister(const UWorld* World, UMultiCollisionMovementComponent* Mover)
+{
+	FMultiCollisionMoverGrid* Grid = MoverGrids.Find(World);
+	if (!Grid)
+	{
+		return;
+	}
+
+	Grid->Movers.Remove(Mover);
+	Grid->UpdateFrame = 0;
+
+	if (Grid->Movers.Num() == 0)
+	{
+		MoverGrids.Remove(World);
+	}
+}
+
+FIntVector FMultiCollisionMoverGrid::GetCell(const FVector& Location) const
+{
+	return FIntVector(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize), FMath::FloorToInt(Location.Z / CellSize));
+}
+
+void FMultiCollisionMoverGrid::Update()
+{
+	if (UpdateFrame == GFrameCounter)
+	{
+		return;
+	}
+
+	UpdateFrame = GFrameCounter;
+	CellSize = FMath::Max(MoverGridCellSizeCVar, 1.f);
+
+	// cells keep their arrays between frames to avoid reallocations, cells which were empty on the last frame are removed
+	for (auto It = Cells.CreateIterator(); It; ++It)
+	{
+		if (It.Value().Num() == 0)
+		{
+			It.RemoveCurrent();
+		}
+		else
+		{
+			It.Value().Reset();
+		}
+	}
+
+	Movers.RemoveAll([](const TWeakObjectPtr<UMultiCollisionMovementComponent>& Mover) { return !Mover.IsValid(); });
+	MoverBounds.SetNumUninitialized(Movers.Num());
+
+	for (int32 MoverIndex = 0; MoverIndex < Movers.Num(); MoverIndex++)
+	{
+		const UMultiCollisionMovementComponent* Mover = Movers[MoverIndex].Get();
+
+		// movers are moved during the frame after the update, so bounds cover the move on this frame
+		FBox Bounds = Mover->GetMoverBounds();
+		if (Bounds.IsValid && Mover->GetWorld())
+		{
+			Bounds = Bounds.ExpandBy(Mover->Velocity.Size() * Mover->GetWorld()->GetDeltaSeconds());
+		}
+
+		MoverBounds[MoverIndex] = Bounds;
+		if (!Bounds.IsValid)
+		{
+			continue;
+		}
+
+		const FIntVector MinCell = GetCell(Bounds.Min);
+		const FIntVector MaxCell = GetCell(Bounds.Max);
+		for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+		{
+			for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+			{
+				for (int32 Z = MinCell.Z; Z <= MaxCell.Z; Z++)
+				{
+					Cells.FindOrAdd(FIntVector(X, Y, Z)).Add(MoverIndex);
+				}
+			}
+		}
+	}
+}
+
+void FMultiCollisionMoverGrid::Query(const FBox& QueryBox, const UMultiCollisionMovementComponent* IgnoredMover, TArray<UMultiCollisionMovementComponent*>& OutMovers)
+{
+	Update();
+
+	const FIntVector MinCell = GetCell(QueryBox.Min);
+	const FIntVector MaxCell = GetCell(QueryBox.Max);
+	for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+		{
+			for (int32 Z = MinCell.Z; Z <= MaxCell.Z; Z++)
+			{
+				const TArray<int32>* Cell = Cells.Find(FIntVector(X, Y, Z));
+				if (!Cell)
+				{
+					continue;
+				}
+
+				for (int32 i = 0; i < Cell->Num(); i++)
+				{
+					const int32 MoverIndex = (*Cell)[i];
+					UMultiCollisionMovementComponent* Mover = Movers[MoverIndex].Get();
+					if (Mover && Mover != IgnoredMover && MoverBounds[MoverIndex].Intersect(QueryBox))
+					{
+						OutMovers.AddUnique(Mover);
+					}
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "CoreMinimal.h"
+
+class UWorld;
+class UMultiCollisionMovementComponent;
+
+/**
+ * Uniform grid of multi-collision movers of one world.
+ * The grid is rebuilt once per frame on the first query, so many movers flying close to each other find their neighbours without the world query,
+ * and ship to ship blocking is resolved by direct sweeps against neighbour components.
+ */
+class FMultiCollisionMoverGrid
+{
+public:
+
+	FMultiCollisionMoverGrid();
+
+	/** Grid of the world, created on first use */
+	static FMultiCollisionMoverGrid& Get(const UWorld* World);
+
+	void Register(UMultiCollisionMovementComponent* Mover);
+
+	/** Unregister the mover, the grid of the world is destroyed with the last mover */
+	static void Unregister(const UWorld* World, UMultiCollisionMovementComponent* Mover);
+
+	/** Collect movers which bounds overlap QueryBox, except IgnoredMover */
+	void Query(const FBox& QueryBox, const UMultiCollisionMovementComponent* IgnoredMover, TArray<UMultiCollisionMovementComponent*>& OutMovers);
+
+private:
+
+	/** Put all movers to the cells if it was not done on this frame */
+	void Update();
+
+	FIntVector GetCell(const FVector& Location) const;
+
+	/** Registered movers */
+	TArray<TWeakObjectPtr<UMultiCollisionMovementComponent>> Movers;
+
+	/** Bounds of the movers on the moment of the update, indices match Movers */
+	TArray<FBox> MoverBounds;
+
+	/** Indices of the movers in every cell */
+	TMap<FIntVector, TArray<int32>> Cells;
+
+	/** Size of the cell the grid was built with */
+	float CellSize;
+
+	/** Frame of the last update */
+	uint64 UpdateFrame;
+};
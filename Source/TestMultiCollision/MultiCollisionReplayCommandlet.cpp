@@ -0,0 +1,185 @@
+#include "MultiCollisionReplayCommandlet.h"
+#include "MultiCollisionCharacter.h"
+#include "MultiCollisionMovementComponent.h"
+#include "MultiCollisionMoveRecorder.h"
+
+#include "Runtime/Engine/Classes/Engine/World.h"
+#include "Runtime/Engine/Classes/Engine/LevelStreaming.h"
+#include "Runtime/Engine/Classes/Components/PrimitiveComponent.h"
+#include "Runtime/CoreUObject/Public/UObject/Package.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogMultiCollisionReplay, Log, All);
+
+UMultiCollisionReplayCommandlet::UMultiCollisionReplayCommandlet(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+static UWorld* LoadReplayWorld(const FString& MapName, const TArray<FString>& StreamingLevels)
+{
+	UPackage* MapPackage = LoadPackage(nullptr, *MapName, LOAD_None);
+	UWorld* World = MapPackage ? UWorld::FindWorldInPackage(MapPackage) : nullptr;
+	if (!World)
+	{
+		return nullptr;
+	}
+
+	World->AddToRoot();
+	World->WorldType = EWorldType::Editor;
+
+	if (!World->bIsWorldInitialized)
+	{
+		UWorld::InitializationValues IVS;
+		IVS.RequiresHitProxies(false).ShouldSimulatePhysics(false).EnableTraceCollision(true).CreateNavigation(false).CreateAISystem(false).AllowAudioPlayback(false).CreatePhysicsScene(true);
+		World->InitWorld(IVS);
+	}
+
+	World->UpdateWorldComponents(true, false);
+
+	// streaming levels are a part of the recorded world, only the levels which were visible on recording are loaded
+	TArray<FString> MissingLevels = StreamingLevels;
+	for (int32 i = 0; i < World->StreamingLevels.Num(); i++)
+	{
+		ULevelStreaming* StreamingLevel = World->StreamingLevels[i];
+		if (!StreamingLevel)
+		{
+			continue;
+		}
+
+		const bool bRecorded = MissingLevels.Remove(UWorld::RemovePIEPrefix(StreamingLevel->GetWorldAssetPackageName())) > 0;
+		StreamingLevel->bShouldBeLoaded = bRecorded;
+		StreamingLevel->bShouldBeVisible = bRecorded;
+#if WITH_EDITORONLY_DATA
+		StreamingLevel->bShouldBeVisibleInEditor = bRecorded; // replay world is an editor world
+#endif
+	}
+
+	World->FlushLevelStreaming(EFlushLevelStreamingType::Full);
+
+	for (int32 i = 0; i < MissingLevels.Num(); i++)
+	{
+		UE_LOG(LogMultiCollisionReplay, Warning, TEXT("Recorded streaming level %s is not found in %s, moves near it will diverge"), *MissingLevels[i], *MapName);
+	}
+
+	return World;
+}
+
+int32 UMultiCollisionReplayCommandlet::Main(const FString& Params)
+{
+	FString StreamFile;
+	if (!FParse::Value(*Params, TEXT("Stream="), StreamFile))
+	{
+		UE_LOG(LogMultiCollisionReplay, Error, TEXT("Usage: -run=MultiCollisionReplay -Stream=<file.mcmove> [-Map=<package>] [-Tolerance=<cm>]"));
+		return 1;
+	}
+
+	FMultiCollisionMoveStreamHeader Header;
+	FMultiCollisionMoveReader Reader;
+	if (!Reader.Open(StreamFile, Header))
+	{
+		UE_LOG(LogMultiCollisionReplay, Error, TEXT("Can't read move stream %s"), *StreamFile);
+		return 1;
+	}
+
+	FString MapName = Header.MapName;
+	FParse::Value(*Params, TEXT("Map="), MapName);
+
+	float Tolerance = 0.01f;
+	FParse::Value(*Params, TEXT("Tolerance="), Tolerance);
+
+	UWorld* World = LoadReplayWorld(MapName, Header.StreamingLevels);
+	if (!World)
+	{
+		UE_LOG(LogMultiCollisionReplay, Error, TEXT("Can't load map %s"), *MapName);
+		return 1;
+	}
+
+	UClass* CharacterClass = LoadClass<AMultiCollisionCharacter>(nullptr, *Header.CharacterClass);
+	if (!CharacterClass)
+	{
+		UE_LOG(LogMultiCollisionReplay, Error, TEXT("Can't load character class %s"), *Header.CharacterClass);
+		return 1;
+	}
+
+	FMultiCollisionMoveRecord Record;
+	if (!Reader.Read(Record))
+	{
+		UE_LOG(LogMultiCollisionReplay, Warning, TEXT("Move stream %s is empty"), *StreamFile);
+		return 0;
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	AMultiCollisionCharacter* Character = World->SpawnActor<AMultiCollisionCharacter>(CharacterClass, Record.StartLocation, Record.StartRotation.Rotator(), SpawnParams);
+	UMultiCollisionMovementComponent* Movement = Character ? Cast<UMultiCollisionMovementComponent>(Character->GetCharacterMovement()) : nullptr;
+	if (!Movement)
+	{
+		UE_LOG(LogMultiCollisionReplay, Error, TEXT("Can't spawn %s with multi-collision movement"), *Header.CharacterClass);
+		return 1;
+	}
+
+	TArray<FString> ComponentNames;
+	Movement->GetAdditionalUpdatedComponentNames(ComponentNames);
+	if (ComponentNames != Header.ComponentNames)
+	{
+		UE_LOG(LogMultiCollisionReplay, Warning, TEXT("Additional components of %s don't match the recorded ones, blocked component can't be compared"), *Header.CharacterClass);
+	}
+
+	int32 NumMoves = 0;
+	int32 NumBlocked = 0;
+	int32 NumDiverged = 0;
+	int32 FirstDivergedMove = INDEX_NONE;
+	uint64 TotalCycles = 0;
+	uint32 MaxCycles = 0;
+	int32 MaxCyclesMove = INDEX_NONE;
+
+	do
+	{
+		// every move starts from the recorded transform, so a divergence doesn't propagate to the next moves
+		Character->SetActorLocationAndRotation(Record.StartLocation, Record.StartRotation, false, nullptr, ETeleportType::TeleportPhysics);
+		Movement->MoveComponentFlags = (EMoveComponentFlags)Record.MoveFlags;
+
+		FHitResult Hit(1.f);
+		const uint32 StartCycles = FPlatformTime::Cycles();
+		const bool bMoved = Movement->MoveUpdatedComponent(Record.Delta, Record.Rotation, Record.bSweep, &Hit);
+		const uint32 MoveCycles = FPlatformTime::Cycles() - StartCycles;
+
+		TotalCycles += MoveCycles;
+		if (MoveCycles > MaxCycles)
+		{
+			MaxCycles = MoveCycles;
+			MaxCyclesMove = NumMoves;
+		}
+
+		const int32 BlockedComponentIndex = bMoved ? INDEX_NONE : ComponentNames.IndexOfByKey(GetNameSafe(Movement->GetLastBlockedComponent()));
+
+		const bool bDiverged = bMoved != Record.bMoved
+			|| !FVector::PointsAreNear(Movement->UpdatedComponent->GetComponentLocation(), Record.EndLocation, Tolerance)
+			|| (!bMoved && (!FMath::IsNearlyEqual(Hit.Time, Record.HitTime, KINDA_SMALL_NUMBER) || BlockedComponentIndex != Record.BlockedComponentIndex));
+
+		if (bDiverged)
+		{
+			if (FirstDivergedMove == INDEX_NONE)
+			{
+				FirstDivergedMove = NumMoves;
+			}
+
+			UE_LOG(LogMultiCollisionReplay, Verbose, TEXT("Move %d (frame %u) diverged: moved %d/%d time %f/%f end %s/%s"), NumMoves, Record.Frame, bMoved, Record.bMoved, Hit.Time, Record.HitTime,
+				*Movement->UpdatedComponent->GetComponentLocation().ToString(), *Record.EndLocation.ToString());
+			NumDiverged++;
+		}
+
+		NumBlocked += bMoved ? 0 : 1;
+		NumMoves++;
+	}
+	while (Reader.Read(Record));
+
+	const double TotalMs = FPlatformTime::ToMilliseconds64(TotalCycles);
+	UE_LOG(LogMultiCollisionReplay, Display, TEXT("Replayed %s on %s: %d moves, %d blocked, %d diverged (first %d)"), *StreamFile, *MapName, NumMoves, NumBlocked, NumDiverged, FirstDivergedMove);
+	UE_LOG(LogMultiCollisionReplay, Display, TEXT("Move cost: total %.3f ms, average %.3f us, max %.3f us (move %d)"), TotalMs, TotalMs * 1000.0 / NumMoves, FPlatformTime::ToMilliseconds(MaxCycles) * 1000.f, MaxCyclesMove);
+
+	return NumDiverged > 0 ? 2 : 0;
+}
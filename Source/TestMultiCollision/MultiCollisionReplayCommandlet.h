@@ -0,0 +1,18 @@
+#pragma once
+#include "Runtime/Engine/Classes/Commandlets/Commandlet.h"
+#include "MultiCollisionReplayCommandlet.generated.h"
+
+/**
+ * Replays recorded move streams (mc.RecordMoves) against the level where they were recorded and reports divergence and cost of every move.
+ * Usage: UE4Editor-Cmd.exe TestMultiCollision -run=MultiCollisionReplay -Stream=<file.mcmove> [-Map=<package>] [-Tolerance=<cm>]
+ */
+UCLASS()
+class UMultiCollisionReplayCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+	UMultiCollisionReplayCommandlet(const FObjectInitializer& ObjectInitializer);
+
+public:
+
+	virtual int32 Main(const FString& Params) override;
+};
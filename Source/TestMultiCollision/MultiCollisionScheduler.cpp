@@ -0,0 +1,158 @@
+#include "MultiCollisionScheduler.h"
+#include "MultiCollisionMovementComponent.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Scheduled updates"), STAT_MultiCollisionScheduledUpdates, STATGROUP_MultiCollision);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Skipped updates"), STAT_MultiCollisionSkippedUpdates, STATGROUP_MultiCollision);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Budget used (ms)"), STAT_MultiCollisionBudgetUsed, STATGROUP_MultiCollision);
+
+static float SchedulerBudgetMsCVar = 0.f;
+static FAutoConsoleVariableRef CVarSchedulerBudgetMs(
+	TEXT("mc.Scheduler.BudgetMs"),
+	SchedulerBudgetMsCVar,
+	TEXT("Frame time budget of multi-collision movement, ms.\n")
+	TEXT("Movers which are not player controlled and not significant are updated round robin inside the budget.\n")
+	TEXT("0: no budget, every mover is updated every frame"),
+	ECVF_Default);
+
+static float SchedulerMaxAccumulatedTimeCVar = 0.25f;
+static FAutoConsoleVariableRef CVarSchedulerMaxAccumulatedTime(
+	TEXT("mc.Scheduler.MaxAccumulatedTime"),
+	SchedulerMaxAccumulatedTimeCVar,
+	TEXT("Max time a scheduled mover can wait for its turn, seconds.\n")
+	TEXT("Mover which waited longer is updated regardless of the budget."),
+	ECVF_Default);
+
+/** Schedulers of all worlds with scheduled movers */
+static TMap<const UWorld*, FMultiCollisionScheduler> Schedulers;
+
+FMultiCollisionScheduler::FMultiCollisionScheduler()
+	: WindowStart(0)
+	, WindowSize(0)
+	, AverageUpdateCost(0.0)
+	, LastFrameFixedCost(0.0)
+	, FrameFixedCost(0.0)
+	, Frame(0)
+{
+
+}
+
+bool FMultiCollisionScheduler::IsEnabled()
+{
+	return SchedulerBudgetMsCVar > 0.f;
+}
+
+FMultiCollisionScheduler& FMultiCollisionScheduler::Get(const UWorld* World)
+{
+	return Schedulers.FindOrAdd(World);
+}
+
+void FMultiCollisionScheduler::Unregister(const UWorld* World, const UMultiCollisionMovementComponent* Mover)
+{
+	FMultiCollisionScheduler* Scheduler = Schedulers.Find(World);
+	if (!Scheduler)
+	{
+		return;
+	}
+
+	Scheduler->Remove(Mover);
+
+	if (Scheduler->Movers.Num() == 0)
+	{
+		Schedulers.Remove(World);
+	}
+}
+
+void FMultiCollisionScheduler::Remove(const UMultiCollisionMovementComponent* Mover)
+{
+	int32 Slot = INDEX_NONE;
+	if (Slots.RemoveAndCopyValue(Mover, Slot))
+	{
+		// the last mover takes the free slot
+		Movers.RemoveAtSwap(Slot);
+		if (Movers.IsValidIndex(Slot))
+		{
+			Slots.Add(Movers[Slot], Slot);
+		}
+
+		// keep the window inside the slots, so slot offsets from the window start stay positive for the rest of the frame
+		const int32 NumMovers = Movers.Num();
+		WindowStart = NumMovers > 0 ? WindowStart % NumMovers : 0;
+		WindowSize = FMath::Min(WindowSize, NumMovers);
+	}
+}
+
+void FMultiCollisionScheduler::BeginFrame()
+{
+	Frame = GFrameCounter;
+
+	LastFrameFixedCost = FrameFixedCost;
+	FrameFixedCost = 0.0;
+
+	const int32 NumMovers = Movers.Num();
+	if (NumMovers == 0)
+	{
+		WindowStart = 0;
+		WindowSize = 0;
+		return;
+	}
+
+	// the budget left after movers which are updated every frame is given to as many scheduled movers as it fits
+	const double RemainingBudget = FMath::Max(SchedulerBudgetMsCVar / 1000.0 - LastFrameFixedCost, 0.0);
+	int32 NewWindowSize = NumMovers;
+	if (AverageUpdateCost > 0.0)
+	{
+		NewWindowSize = FMath::Clamp((int32)(RemainingBudget / AverageUpdateCost), 1, NumMovers);
+	}
+
+	// move the window, so every mover gets its turn
+	WindowStart = (WindowStart + WindowSize) % NumMovers;
+	WindowSize = NewWindowSize;
+}
+
+bool FMultiCollisionScheduler::ShouldUpdate(const UMultiCollisionMovementComponent* Mover, float AccumulatedTime)
+{
+	if (Frame != GFrameCounter)
+	{
+		BeginFrame();
+	}
+
+	int32* SlotPtr = Slots.Find(Mover);
+	if (!SlotPtr)
+	{
+		// new mover gets the turn immediately
+		Slots.Add(Mover, Movers.Add(Mover));
+		INC_DWORD_STAT(STAT_MultiCollisionScheduledUpdates);
+		return true;
+	}
+
+	const int32 NumMovers = Movers.Num();
+	const bool bInWindow = ((*SlotPtr - WindowStart + NumMovers) % NumMovers) < WindowSize;
+
+	if (bInWindow || AccumulatedTime >= SchedulerMaxAccumulatedTimeCVar)
+	{
+		INC_DWORD_STAT(STAT_MultiCollisionScheduledUpdates);
+		return true;
+	}
+
+	INC_DWORD_STAT(STAT_MultiCollisionSkippedUpdates);
+	return false;
+}
+
+void FMultiCollisionScheduler::AddUpdateCost(double Seconds, bool bScheduled)
+{
+	if (Frame != GFrameCounter)
+	{
+		BeginFrame();
+	}
+
+	if (bScheduled)
+	{
+		AverageUpdateCost = AverageUpdateCost > 0.0 ? FMath::Lerp(AverageUpdateCost, Seconds, 0.1) : Seconds;
+	}
+	else
+	{
+		FrameFixedCost += Seconds;
+	}
+
+	INC_FLOAT_STAT_BY(STAT_MultiCollisionBudgetUsed, (float)(Seconds * 1000.0));
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+
+DECLARE_STATS_GROUP(TEXT("MultiCollision"), STATGROUP_MultiCollision, STATCAT_Advanced);
+
+class UWorld;
+class UMultiCollisionMovementComponent;
+
+/**
+ * Frame budget of multi-collision movement of one world.
+ * Player controlled and significant movers are updated every frame, their cost is taken from the budget first.
+ * Other movers get their turns round robin, as many per frame as the rest of the budget allows, and move with the time accumulated since their last turn.
+ */
+class FMultiCollisionScheduler
+{
+public:
+
+	FMultiCollisionScheduler();
+
+	/** True if frame budget is set by mc.Scheduler.BudgetMs */
+	static bool IsEnabled();
+
+	/** Scheduler of the world, created on first use */
+	static FMultiCollisionScheduler& Get(const UWorld* World);
+
+	/** Remove the mover from the schedule, the scheduler of the world is destroyed with the last mover */
+	static void Unregister(const UWorld* World, const UMultiCollisionMovementComponent* Mover);
+
+	/** Free the slot of the mover which doesn't ask for scheduled updates any more (dormant, player controlled or significant), next ShouldUpdate() adds it back */
+	void Remove(const UMultiCollisionMovementComponent* Mover);
+
+	/** Decide if scheduled mover gets its turn on this frame. Mover which waited for too long always gets the turn. */
+	bool ShouldUpdate(const UMultiCollisionMovementComponent* Mover, float AccumulatedTime);
+
+	/** Report the cost of the movement update of any mover */
+	void AddUpdateCost(double Seconds, bool bScheduled);
+
+private:
+
+	/** Finish the last frame statistics and move the round robin window */
+	void BeginFrame();
+
+	/** Slot of every scheduled mover */
+	TMap<const UMultiCollisionMovementComponent*, int32> Slots;
+
+	/** Scheduled movers, index is the slot */
+	TArray<const UMultiCollisionMovementComponent*> Movers;
+
+	/** First slot of the round robin window of this frame */
+	int32 WindowStart;
+
+	/** Number of slots in the round robin window of this frame */
+	int32 WindowSize;
+
+	/** Average cost of one scheduled update, seconds */
+	double AverageUpdateCost;
+
+	/** Cost of movers which are not scheduled on the last frame, seconds */
+	double LastFrameFixedCost;
+
+	/** Cost of movers which are not scheduled on the current frame, seconds */
+	double FrameFixedCost;
+
+	uint64 Frame;
+};
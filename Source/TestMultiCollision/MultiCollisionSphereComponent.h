@@ -0,0 +1,21 @@
+#pragma once
+#include "Runtime/Engine/Classes/Components/SphereComponent.h"
+#include "MultiCollisionComponent.h"
+#include "MultiCollisionSphereComponent.generated.h"
+
+/** Implements the additional sphere component for movement sweep */
+UCLASS(NotBlueprintable, NotBlueprintType, ClassGroup = "Collision", editinlinenew, meta = (BlueprintSpawnableComponent))
+class UMultiCollisionSphereComponent : public USphereComponent, public IMultiCollisionComponent
+{
+	GENERATED_BODY()
+	UMultiCollisionSphereComponent(const FObjectInitializer& ObjectInitializer);
+
+public:
+
+protected:
+
+
+private:
+
+
+};
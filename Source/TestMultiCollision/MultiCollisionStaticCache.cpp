@@ -0,0 +1,264 @@
+#include "MultiCollisionStaticCache.h"
+#include "MultiCollisionComponent.h"
+#include "Runtime/Engine/Classes/Components/PrimitiveComponent.h"
+#include "Runtime/Engine/Classes/Engine/World.h"
+#include "Runtime/Engine/Classes/GameFramework/Actor.h"
+#include "Runtime/Engine/Classes/Components/InstancedStaticMeshComponent.h"
+
+static float StaticCacheCellSizeCVar = 1000.f;
+static FAutoConsoleVariableRef CVarStaticCacheCellSize(
+	TEXT("mc.StaticCache.CellSize"),
+	StaticCacheCellSizeCVar,
+	TEXT("Cell size of the grid of bodies in static geometry cache of multi-collision movers.\n")
+	TEXT("Should be about the size of additional components sweeps."),
+	ECVF_Default);
+
+/** Changed on level streaming and spawn of actors with static collision in any world, caches collected before the change are refreshed */
+static uint32 StaticGeometryGeneration = 0;
+
+/** Actor spawn handlers of worlds with static geometry caches */
+static TMap<const UWorld*, FDelegateHandle> ActorSpawnedHandles;
+
+static void OnLevelChanged(ULevel* Level, UWorld* World)
+{
+	StaticGeometryGeneration++;
+}
+
+static void OnActorSpawned(AActor* Actor)
+{
+	// static and stationary components can't be attached to movable root, so the root tells if the actor has static collision
+	const USceneComponent* RootComponent = Actor ? Actor->GetRootComponent() : nullptr;
+	if (RootComponent && RootComponent->Mobility != EComponentMobility::Movable)
+	{
+		StaticGeometryGeneration++;
+	}
+}
+
+static void OnWorldCleanup(UWorld* World, bool bSessionEnded, bool bCleanupResources)
+{
+	FDelegateHandle Handle;
+	if (ActorSpawnedHandles.RemoveAndCopyValue(World, Handle))
+	{
+		World->RemoveOnActorSpawnedHandler(Handle);
+	}
+}
+
+/** Listen for static geometry changes of the world */
+static void RegisterStaticGeometryDelegates(UWorld* World)
+{
+	static bool bLevelDelegatesRegistered = false;
+	if (!bLevelDelegatesRegistered)
+	{
+		FWorldDelegates::LevelAddedToWorld.AddStatic(&OnLevelChanged);
+		FWorldDelegates::LevelRemovedFromWorld.AddStatic(&OnLevelChanged);
+		FWorldDelegates::OnWorldCleanup.AddStatic(&OnWorldCleanup);
+		bLevelDelegatesRegistered = true;
+	}
+
+	if (!ActorSpawnedHandles.Contains(World))
+	{
+		ActorSpawnedHandles.Add(World, World->AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateStatic(&OnActorSpawned)));
+	}
+}
+
+FMultiCollisionStaticCache::FMultiCollisionStaticCache() : Region(ForceInit), CellSize(StaticCacheCellSizeCVar), Generation(0), SweepStamp(0)
+{
+
+}
+
+void FMultiCollisionStaticCache::Reset()
+{
+	Region = FBox(ForceInit);
+	Bodies.Reset();
+	Cells.Reset();
+	Instances.Reset();
+	BodySweepStamps.Reset();
+	SweepStamp = 0;
+}
+
+bool FMultiCollisionStaticCache::Contains(const FBox& QueryBox) const
+{
+	if (!Region.IsValid || Generation != StaticGeometryGeneration || !Region.IsInside(QueryBox))
+	{
+		return false;
+	}
+
+	// instances of cached meshes were added or removed (destroyed asteroid, removed foliage), cached instance indices are not valid anymore
+	for (int32 i = 0; i < Instances.Num(); i++)
+	{
+		const UInstancedStaticMeshComponent* Component = Instances[i].Component.Get();
+		if (!Component || Component->InstanceBodies.Num() != Instances[i].NumBodies)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+FIntVector FMultiCollisionStaticCache::GetCell(const FVector& Location) const
+{
+	return FIntVector(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize), FMath::FloorToInt(Location.Z / CellSize));
+}
+
+void FMultiCollisionStaticCache::AddBody(UPrimitiveComponent* Primitive, int32 InstanceIndex, const FBox& Bounds)
+{
+	if (!Bounds.IsValid)
+	{
+		return;
+	}
+
+	const int32 BodyIndex = Bodies.AddDefaulted();
+	Bodies[BodyIndex].Primitive = Primitive;
+	Bodies[BodyIndex].InstanceIndex = InstanceIndex;
+	Bodies[BodyIndex].Bounds = Bounds;
+
+	// only the part of the body inside the region is put to cells, sweeps don't leave the region
+	const FBox CellBounds = Bounds.Overlap(Region);
+	if (!CellBounds.IsValid)
+	{
+		return;
+	}
+
+	const FIntVector MinCell = GetCell(CellBounds.Min);
+	const FIntVector MaxCell = GetCell(CellBounds.Max);
+	for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+		{
+			for (int32 Z = MinCell.Z; Z <= MaxCell.Z; Z++)
+			{
+				Cells.FindOrAdd(FIntVector(X, Y, Z)).Add(BodyIndex);
+			}
+		}
+	}
+}
+
+void FMultiCollisionStaticCache::Refresh(UWorld* World, const FBox& QueryBox, float Margin, const FCollisionQueryParams& Params)
+{
+	Reset();
+
+	if (!World || !QueryBox.IsValid)
+	{
+		return;
+	}
+
+	RegisterStaticGeometryDelegates(World);
+	Generation = StaticGeometryGeneration;
+	CellSize = FMath::Max(StaticCacheCellSizeCVar, 1.f);
+
+	Region = QueryBox.ExpandBy(Margin);
+
+	// static and stationary primitives can't move, so it is safe to keep them while we are inside the region. Movable primitives of any object type stay in the world query.
+	FCollisionQueryParams StaticParams(Params);
+	StaticParams.MobilityType = EQueryMobilityType::Static;
+
+	TArray<FOverlapResult> Overlaps;
+	World->OverlapMultiByObjectType(Overlaps, Region.GetCenter(), FQuat::Identity, FCollisionObjectQueryParams(FCollisionObjectQueryParams::InitType::AllObjects), FCollisionShape::MakeBox(Region.GetExtent()), StaticParams);
+
+	// body with several shapes gives several overlaps
+	TSet<const FBodyInstance*> AddedBodies;
+
+	for (int32 i = 0; i < Overlaps.Num(); i++)
+	{
+		UPrimitiveComponent* Primitive = Overlaps[i].GetComponent();
+		if (!Primitive || Primitive->Mobility == EComponentMobility::Movable)
+		{
+			continue;
+		}
+
+		// instanced mesh has no collision in its own body, every instance has its body and the overlap item is the instance index
+		UInstancedStaticMeshComponent* InstancedComponent = Cast<UInstancedStaticMeshComponent>(Primitive);
+		if (InstancedComponent)
+		{
+			const int32 InstanceIndex = Overlaps[i].ItemIndex;
+			const FBodyInstance* InstanceBody = InstancedComponent->InstanceBodies.IsValidIndex(InstanceIndex) ? InstancedComponent->InstanceBodies[InstanceIndex] : nullptr;
+			if (InstanceBody && !AddedBodies.Contains(InstanceBody))
+			{
+				AddedBodies.Add(InstanceBody);
+				AddBody(InstancedComponent, InstanceIndex, InstanceBody->GetBodyBounds());
+
+				if (!Instances.ContainsByPredicate([InstancedComponent](const FCachedInstances& Cached) { return Cached.Component == InstancedComponent; }))
+				{
+					FCachedInstances& Cached = Instances[Instances.AddDefaulted()];
+					Cached.Component = InstancedComponent;
+					Cached.NumBodies = InstancedComponent->InstanceBodies.Num();
+				}
+			}
+		}
+		else if (!AddedBodies.Contains(&Primitive->BodyInstance))
+		{
+			AddedBodies.Add(&Primitive->BodyInstance);
+			AddBody(Primitive, INDEX_NONE, Primitive->Bounds.GetBox());
+		}
+	}
+
+	BodySweepStamps.SetNumZeroed(Bodies.Num());
+}
+
+void FMultiCollisionStaticCache::Sweep(TArray<FHitResult>& OutHits, const UPrimitiveComponent* SweptComponent, const FVector& Start, const FVector& End, const FQuat& Rotation, const FCollisionShape& Shape) const
+{
+	const FBox SweepBox = IMultiCollisionComponent::GetSweepBox(Start, End, Shape).Overlap(Region);
+	if (!SweepBox.IsValid)
+	{
+		return;
+	}
+
+	SweepStamp++;
+	if (SweepStamp == 0)
+	{
+		// stamps wrapped around, so old stamps can't match the new ones
+		FMemory::Memzero(BodySweepStamps.GetData(), BodySweepStamps.Num() * sizeof(uint32));
+		SweepStamp = 1;
+	}
+
+	// only bodies in the cells of the sweep are tested, responses of both components are tested for every body, cached geometry can have any object type
+	const FIntVector MinCell = GetCell(SweepBox.Min);
+	const FIntVector MaxCell = GetCell(SweepBox.Max);
+	for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+		{
+			for (int32 Z = MinCell.Z; Z <= MaxCell.Z; Z++)
+			{
+				const TArray<int32>* Cell = Cells.Find(FIntVector(X, Y, Z));
+				if (!Cell)
+				{
+					continue;
+				}
+
+				for (int32 i = 0; i < Cell->Num(); i++)
+				{
+					const int32 BodyIndex = (*Cell)[i];
+					if (BodySweepStamps[BodyIndex] == SweepStamp)
+					{
+						continue;
+					}
+
+					BodySweepStamps[BodyIndex] = SweepStamp;
+
+					const FCachedBody& Cached = Bodies[BodyIndex];
+					UPrimitiveComponent* Primitive = Cached.Primitive.Get();
+					if (!SweepBox.Intersect(Cached.Bounds) || !IMultiCollisionComponent::ShouldBlock(SweptComponent, Primitive))
+					{
+						continue;
+					}
+
+					const FBodyInstance* Body = &Primitive->BodyInstance;
+					if (Cached.InstanceIndex != INDEX_NONE)
+					{
+						const UInstancedStaticMeshComponent* InstancedComponent = static_cast<const UInstancedStaticMeshComponent*>(Primitive);
+						Body = InstancedComponent->InstanceBodies.IsValidIndex(Cached.InstanceIndex) ? InstancedComponent->InstanceBodies[Cached.InstanceIndex] : nullptr;
+					}
+
+					FHitResult Hit(1.f);
+					if (Body && Body->Sweep(Hit, Start, End, Rotation, Shape, Primitive->bTraceComplexOnMove))
+					{
+						Hit.bBlockingHit = true;
+						OutHits.Add(Hit);
+					}
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "Runtime/Engine/Classes/Engine/EngineTypes.h"
+#include "Runtime/Engine/Public/CollisionQueryParams.h"
+
+class UPrimitiveComponent;
+class UInstancedStaticMeshComponent;
+
+/**
+ * Cache of static world geometry around a multi-collision mover.
+ * Collision bodies which can't move (static and stationary mobility) inside the cached region are collected once and sweeps of additional components test against them directly.
+ * Instanced static meshes (foliage, asteroid fields) are cached per instance body. Bodies are put to the grid of cells, so a sweep tests only bodies near it.
+ * The world query is needed only for movable objects. The cache is refreshed when the mover leaves the cached region, when a level is streamed, when an actor with static collision is spawned
+ * or when instances of a cached instanced mesh are added or removed.
+ */
+struct FMultiCollisionStaticCache
+{
+	FMultiCollisionStaticCache();
+
+	/** Forget all cached bodies. Next move will refresh the cache. */
+	void Reset();
+
+	/** Returns true if cache was collected after the last static geometry change and QueryBox is fully inside of the cached region */
+	bool Contains(const FBox& QueryBox) const;
+
+	/** Collect static bodies overlapping QueryBox expanded by Margin */
+	void Refresh(UWorld* World, const FBox& QueryBox, float Margin, const FCollisionQueryParams& Params);
+
+	/** Sweep the shape of SweptComponent against cached bodies near the sweep and add blocking hits to OutHits */
+	void Sweep(TArray<FHitResult>& OutHits, const UPrimitiveComponent* SweptComponent, const FVector& Start, const FVector& End, const FQuat& Rotation, const FCollisionShape& Shape) const;
+
+private:
+
+	/** Collision body of the cached primitive */
+	struct FCachedBody
+	{
+		TWeakObjectPtr<UPrimitiveComponent> Primitive;
+
+		/** Index of the instance body of instanced static mesh, INDEX_NONE for the body of the primitive */
+		int32 InstanceIndex;
+
+		FBox Bounds;
+	};
+
+	/** Instanced static mesh and the number of its instance bodies on the refresh */
+	struct FCachedInstances
+	{
+		TWeakObjectPtr<UInstancedStaticMeshComponent> Component;
+		int32 NumBodies;
+	};
+
+	FIntVector GetCell(const FVector& Location) const;
+
+	void AddBody(UPrimitiveComponent* Primitive, int32 InstanceIndex, const FBox& Bounds);
+
+	/** Region covered by the cache */
+	FBox Region;
+
+	/** Static bodies inside the region */
+	TArray<FCachedBody> Bodies;
+
+	/** Indices of the bodies in every cell */
+	TMap<FIntVector, TArray<int32>> Cells;
+
+	/** Size of the cell the cache was built with */
+	float CellSize;
+
+	/** Instanced meshes of the cache, the cache is outdated when their instances are added or removed */
+	TArray<FCachedInstances> Instances;
+
+	/** Static geometry generation the cache was collected on */
+	uint32 Generation;
+
+	/** Stamp of the last sweep which tested the body, indices match Bodies. Bodies in several cells are tested once per sweep. */
+	mutable TArray<uint32> BodySweepStamps;
+	mutable uint32 SweepStamp;
+};